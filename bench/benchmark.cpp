@@ -0,0 +1,393 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+#include <limits>
+#include "cmdparser.h"
+#include "configuration.h"
+#include "integrator.h"
+#include "lattice.h"
+#include "philox.h"
+#include "kernels.h"
+#include "autocorrelation.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace physics;
+using namespace statistics;
+
+/**
+* The timing of a single benchmark case.
+*/
+struct Result {
+	string name;
+	int size;
+	double ns_per_call;
+	double ns_per_site;
+	double rate;
+	double bytes;
+};
+
+void setup(CmdParser& parser) {
+	parser.set_optional<string>("o", "output", "benchmark.json", "The name of the JSON file for the results.");
+	parser.set_optional<string>("b", "baseline", "", "The JSON file of a previous run to compare against.");
+	parser.set_optional<string>("n", "nt", "100,1000,10000,100000", "The comma separated lattice sizes.");
+	parser.set_optional<int>("d", "dimensions", 1, "The number of dimensions of the lattices, each with the given size.");
+	parser.set_optional<int>("e", "domains", 1, "The number of domains, i.e. threads, of the lattices.");
+	parser.set_optional<string>("m", "nmeas", "1000,10000,100000", "The comma separated numbers of measurements for the autocorrelation.");
+	parser.set_optional<double>("l", "lambda", 0.5, "The anharmonic coupling λ of the lattices.");
+	parser.set_optional<int>("r", "nsteps", 10, "The number of integration steps per trajectory.");
+	parser.set_optional<double>("T", "time", 0.2, "The minimum number of seconds that a single measurement takes.");
+	parser.set_optional<int>("R", "repeat", 3, "The number of measurements per case, of which the fastest is kept.");
+	parser.set_optional<double>("t", "tolerance", 0.1, "The relative slowdown against the baseline that is considered a regression.");
+}
+
+vector<int> parse_sizes(const string& list) {
+	vector<int> sizes { };
+	stringstream ss { list };
+	string item { };
+
+	while (getline(ss, item, ','))
+		sizes.push_back(stoi(item));
+
+	return sizes;
+}
+
+/**
+* Measures the time of an operation, which is repeated until the minimum time has passed.
+*
+* @param The operation to measure.
+* @param The minimum number of seconds of a measurement.
+* @param The number of measurements, of which the fastest is taken.
+* @return The number of nanoseconds per call.
+*/
+double measure(function<void()> operation, double seconds, int repeat) {
+	using chrono::duration;
+	using chrono::steady_clock;
+
+	auto best = 0.0;
+	long calls = 1;
+	operation();
+
+	for (int r = 0; r < repeat; ++r) {
+		for (;;) {
+			const auto begin = steady_clock::now();
+
+			for (long i = 0; i < calls; ++i)
+				operation();
+
+			const auto elapsed = duration<double>(steady_clock::now() - begin).count();
+
+			if (elapsed >= seconds || calls >= (1L << 40)) {
+				const auto ns = 1e9 * elapsed / static_cast<double>(calls);
+				best = r == 0 ? ns : min(best, ns);
+				break;
+			}
+
+			calls = elapsed > 0.0 ? max(2 * calls, static_cast<long>(1.1 * calls * seconds / elapsed)) : 2 * calls;
+		}
+	}
+
+	return best;
+}
+
+Result make_result(const string& name, int size, double sites, double ns, double bytes) {
+	return Result { name, size, ns, ns / sites, 1e9 / ns, bytes };
+}
+
+void benchmark_lattice(int nt, int dimensions, int domains, double lambda, int nsteps, double seconds, int repeat, vector<Result>& results) {
+	mt19937 rng { 42 };
+	uniform_real_distribution<double> dist { 0.0, 1.0 };
+	const Integrator integrator { Scheme::leapfrog, nsteps, 1.0 };
+	Lattice lattice { rng, nt, integrator, 1.0, lambda, false, dimensions, domains };
+	const auto sites = Lattice::sites(nt, dimensions);
+	const auto bytes = static_cast<double>(lattice.footprint());
+	auto suffix = dimensions > 1 ? "_" + to_string(dimensions) + "d" : string { };
+
+	if (lattice.domains() > 1)
+		suffix += "_" + to_string(lattice.domains()) + "t";
+	const auto kernel = kernels::specialize(nt, lambda, dimensions);
+	auto sink = 0.0;
+
+	lattice.randomize();
+	results.push_back(make_result("randomize" + suffix, sites, sites, measure([&lattice]() {
+		lattice.randomize();
+	}, seconds, repeat), bytes));
+
+	Lattice counter { rng, nt, integrator, 1.0, lambda, false, dimensions, domains };
+	counter.generator(numerics::Philox { 42 });
+	results.push_back(make_result("randomize_philox" + suffix, sites, sites, measure([&counter]() {
+		counter.randomize();
+	}, seconds, repeat), bytes));
+
+	results.push_back(make_result("integrate" + suffix, sites, 1.0 * sites * nsteps, measure([&lattice]() {
+		lattice.integrate();
+	}, seconds, repeat), bytes));
+
+	// The energies are cached, hence a site and a momentum are set to force their recomputation.
+	results.push_back(make_result("hamilton" + suffix, sites, sites, measure([&lattice, &sink]() {
+		lattice.x(0, lattice.x(0));
+		lattice.p(0, lattice.p(0));
+		sink += lattice.hamilton();
+	}, seconds, repeat), bytes));
+
+	// A trajectory including the accept / reject step, as done by Harmonic::step.
+	results.push_back(make_result("step" + suffix, sites, 1.0 * sites * nsteps, measure([&lattice, &rng, &dist]() {
+		lattice.randomize();
+		lattice.store();
+		const auto a = lattice.hamilton();
+		lattice.integrate();
+		const auto delta = lattice.hamilton() - a;
+
+		if (delta > 0.0 && dist(rng) > exp(-delta))
+			lattice.restore();
+	}, seconds, repeat), bytes));
+
+	auto x = kernels::allocate(sites);
+	auto p = kernels::allocate(sites);
+
+	for (int i = 0; i < sites; ++i) {
+		x[i] = dist(rng) - 0.5;
+		p[i] = 0.0;
+	}
+
+	x[-1] = x[sites - 1];
+	x[sites] = x[0];
+
+	// The force of all sites applied to the momenta, which is what Lattice::force computes for a single site.
+	results.push_back(make_result("force" + suffix, sites, sites, measure([x, p, nt, dimensions, lambda, &kernel, &sink]() {
+		sink += kernel.kick(p, x, 2.0 * dimensions + 1.0, lambda, 1e-9, nt);
+	}, seconds, repeat), 2.0 * sizeof(double) * sites));
+
+	kernels::release(x);
+	kernels::release(p);
+
+	if (sink == 0.123456789)
+		cout << sink << endl;
+}
+
+void benchmark_autocorrelation(int nmeas, double seconds, int repeat, vector<Result>& results) {
+	mt19937 rng { 42 };
+	normal_distribution<double> gauss { };
+	vector<double> elements(nmeas);
+	auto value = 0.0;
+	auto sink = 0.0;
+
+	for (auto& element : elements) {
+		value = 0.9 * value + gauss(rng);
+		element = value;
+	}
+
+	AutoCorrelation correlation { elements };
+
+	results.push_back(make_result("autocorrelation", nmeas, nmeas, measure([&correlation, &sink]() {
+		sink += correlation.compute().mean;
+	}, seconds, repeat), sizeof(double) * nmeas));
+
+	if (sink == 0.123456789)
+		cout << sink << endl;
+}
+
+double peak_memory() {
+#ifndef _WIN32
+	rusage usage { };
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return static_cast<double>(usage.ru_maxrss);
+#else
+	return 1024.0 * static_cast<double>(usage.ru_maxrss);
+#endif
+#else
+	return 0.0;
+#endif
+}
+
+void write_json(ostream& os, const vector<Result>& results) {
+	os << setprecision(10);
+	os << "{" << endl;
+	os << "  \"instruction_set\": \"" << kernels::instruction_set() << "\"," << endl;
+	os << "  \"peak_memory\": " << peak_memory() << "," << endl;
+	os << "  \"benchmarks\": [" << endl;
+
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto& r = results[i];
+		os << "    { \"name\": \"" << r.name << "\", \"size\": " << r.size;
+		os << ", \"ns_per_call\": " << r.ns_per_call << ", \"ns_per_site\": " << r.ns_per_site;
+		os << ", \"rate\": " << r.rate << ", \"bytes\": " << r.bytes << " }";
+		os << (i + 1 < results.size() ? "," : "") << endl;
+	}
+
+	os << "  ]" << endl;
+	os << "}" << endl;
+}
+
+/**
+* Reads the results from a JSON file written by write_json. Only the flat
+* objects of the benchmarks array are considered.
+*
+* @param The name of the file.
+* @param The target for the results.
+* @return True if the file could be read.
+*/
+bool read_json(const string& name, vector<Result>& results) {
+	ifstream input { name };
+
+	if (!input.is_open())
+		return false;
+
+	const string text { istreambuf_iterator<char>(input), istreambuf_iterator<char>() };
+	const auto field = [](const string& object, const string& key) {
+		const auto start = object.find("\"" + key + "\":");
+
+		if (start == string::npos)
+			return string { };
+
+		auto begin = object.find_first_not_of(" \"", start + key.size() + 3);
+		auto end = object.find_first_of(",\"}", begin);
+		return object.substr(begin, end - begin);
+	};
+	auto position = text.find("\"benchmarks\"");
+
+	while (position != string::npos) {
+		const auto begin = text.find('{', position);
+		const auto end = text.find('}', begin);
+
+		if (begin == string::npos || end == string::npos)
+			break;
+
+		const auto object = text.substr(begin, end - begin + 1);
+		const auto ns = field(object, "ns_per_call");
+
+		// A malformed object, e.g. one without a size, makes the whole baseline unreadable.
+		try {
+			if (ns.size() > 0)
+				results.push_back(Result { field(object, "name"), stoi(field(object, "size")), stod(ns), 0.0, 0.0, 0.0 });
+		} catch (const exception&) {
+			return false;
+		}
+
+		position = end;
+	}
+
+	return true;
+}
+
+int compare(const vector<Result>& results, const vector<Result>& baseline, double tolerance) {
+	auto regressions = 0;
+
+	cout << endl << "Comparison against the baseline ..." << endl;
+
+	for (const auto& r : results) {
+		const auto previous = find_if(baseline.begin(), baseline.end(), [&r](const Result& b) {
+			return b.name == r.name && b.size == r.size;
+		});
+
+		if (previous == baseline.end())
+			continue;
+
+		const auto ratio = r.ns_per_call / previous->ns_per_call;
+		cout << setw(18) << left << r.name << setw(10) << right << r.size << setw(12) << fixed << setprecision(3) << ratio << "x";
+
+		if (ratio > 1.0 + tolerance) {
+			cout << "  REGRESSION";
+			++regressions;
+		} else if (ratio < 1.0 / (1.0 + tolerance))
+			cout << "  improved";
+
+		cout << endl;
+	}
+
+	return regressions;
+}
+
+int main(int argc, char** argv) {
+	CmdParser cmd { argc, argv };
+	setup(cmd);
+
+	if (cmd.parse() == false)
+		return 1;
+
+	vector<Result> results { };
+	const auto seconds = cmd.get<double>("T");
+	const auto repeat = max(cmd.get<int>("R"), 1);
+	const auto dimensions = cmd.get<int>("d");
+
+	if (dimensions < 1 || dimensions > 4) {
+		cerr << "The lattices require 1 to 4 dimensions." << endl;
+		return 1;
+	}
+
+	cout << "Instruction set: " << kernels::instruction_set() << endl;
+	cout << setw(18) << left << "name" << setw(10) << right << "size" << setw(14) << "ns/call" << setw(12) << "ns/site" << setw(14) << "calls/s" << endl;
+
+	const auto print = [](const Result& r) {
+		cout << setw(18) << left << r.name << setw(10) << right << r.size << setw(14) << fixed << setprecision(1) << r.ns_per_call;
+		cout << setw(12) << setprecision(3) << r.ns_per_site << setw(14) << setprecision(1) << r.rate << endl;
+	};
+
+	for (const auto nt : parse_sizes(cmd.get<string>("n"))) {
+		if (pow(static_cast<double>(nt), dimensions) > numeric_limits<int>::max()) {
+			cerr << "Skipping the size " << nt << ", as the lattice has too many sites." << endl;
+			continue;
+		}
+
+		const auto first = results.size();
+		benchmark_lattice(nt, dimensions, cmd.get<int>("e"), cmd.get<double>("l"), cmd.get<int>("r"), seconds, repeat, results);
+		for_each(results.begin() + first, results.end(), print);
+	}
+
+	for (const auto nmeas : parse_sizes(cmd.get<string>("m"))) {
+		const auto first = results.size();
+		benchmark_autocorrelation(nmeas, seconds, repeat, results);
+		for_each(results.begin() + first, results.end(), print);
+	}
+
+	ofstream output { cmd.get<string>("o") };
+	write_json(output, results);
+	cout << "Peak memory: " << peak_memory() / (1024.0 * 1024.0) << " MB" << endl;
+
+	if (cmd.get<string>("b").size() > 0) {
+		vector<Result> baseline { };
+
+		if (!read_json(cmd.get<string>("b"), baseline)) {
+			cerr << "The baseline " << cmd.get<string>("b") << " could not be read." << endl;
+			return 1;
+		}
+
+		if (compare(results, baseline, cmd.get<double>("t")) > 0)
+			return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include "fourier.h"
+#include <vector>
+#include <complex>
+
+namespace physics {
+	/**
+	* Fourier acceleration with a kinetic mass that is diagonal in momentum space. The mass
+	* M_k = (4 sin²(πk / Nt) + ω²) / (4 + ω²) follows the free spectrum, such that all modes
+	* move at the speed of the highest mode. If Nt is not a power of 2 the cyclic convolution
+	* is computed from the periodically extended values with a padded power of 2 transform.
+	*/
+	class Acceleration final {
+	public:
+		/**
+		* Constructs the mass spectrum for the given lattice.
+		*
+		* @param The number of temporal sites.
+		* @param The harmonic parameter, ω².
+		*/
+		Acceleration(int nt, double omegasq) noexcept;
+
+		/**
+		* Transforms Gaussian noise into momenta with the mass as covariance, p = M^½ ξ.
+		*
+		* @param The noise ξ.
+		* @param The target for the momenta p, which may be the noise.
+		* @param The distance between neighbouring sites in the arrays.
+		*/
+		void momenta(const double* noise, double* p, int stride = 1) noexcept;
+
+		/**
+		* Computes the velocities of the momenta, v = M⁻¹ p.
+		*
+		* @param The momenta p.
+		* @param The target for the velocities v.
+		* @param The distance between neighbouring sites in the arrays.
+		* @return The value of Σ p v, i.e. twice the kinetic energy.
+		*/
+		double velocities(const double* p, double* v, int stride = 1) noexcept;
+
+	protected:
+		/**
+		* Multiplies the strided values with a function of the mass in momentum space.
+		*
+		* @param The values.
+		* @param The target for the new values.
+		* @param The distance between neighbouring sites in the arrays.
+		* @param The spectrum of the filter in the padded transform.
+		*/
+		void filter(const double* input, double* output, int stride, const std::vector<std::complex<double>>& factors) noexcept;
+
+		/**
+		* Computes the spectrum of a filter in the padded transform.
+		*
+		* @param The factors of the non-redundant modes of the lattice.
+		* @return The factors of the non-redundant modes of the padded transform.
+		*/
+		std::vector<std::complex<double>> pad(const std::vector<std::complex<double>>& factors) noexcept;
+
+	private:
+		int nt;
+		int offset;
+		numerics::FourierTransform fft;
+		std::vector<std::complex<double>> root;
+		std::vector<std::complex<double>> inverse;
+		std::vector<double> values;
+		std::vector<std::complex<double>> spectrum;
+	};
+}
@@ -0,0 +1,74 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+
+namespace physics {
+	/**
+	* Adaptation of the integration step size by dual averaging (Nesterov; Hoffman, Gelman),
+	* which drives the average acceptance probability towards a target value.
+	*/
+	class DualAveraging final {
+	public:
+		/**
+		* Constructs a new adaptation.
+		*
+		* @param The target acceptance probability.
+		* @param The initial step size.
+		*/
+		DualAveraging(double target, double eps) noexcept;
+
+		/**
+		* Updates the step size with the acceptance probability of a trajectory.
+		*
+		* @param The acceptance probability min(1, exp(-ΔH)).
+		* @return The step size for the next trajectory.
+		*/
+		double update(double acceptance) noexcept;
+
+		/**
+		* Gets the current step size.
+		*
+		* @return The step size for the next trajectory.
+		*/
+		double step_size() const noexcept;
+
+		/**
+		* Gets the averaged step size, which should be used once the adaptation is finished.
+		*
+		* @return The final step size.
+		*/
+		double average() const noexcept;
+
+		/**
+		* Gets the number of updates.
+		*
+		* @return The number of adapted trajectories.
+		*/
+		int iterations() const noexcept;
+
+	private:
+		double target;
+		double mu;
+		double statistic;
+		double log_eps;
+		double log_average;
+		int m;
+	};
+}
@@ -67,13 +67,13 @@ namespace statistics {
 		double sigma() const noexcept;
 
 		/**
-		* Computes the standard deviation values for the autocorrelation values.
+		* Computes the standard deviation of a single autocorrelation value.
 		*
-		* @param The number of elements to consider at maximum.
+		* @param The lag of the autocorrelation value.
 		* @param The autocorrelation values that should be used.
-		* @param The target where the respective standard deviations are stored.
+		* @return The standard deviation of the autocorrelation at the given lag.
 		*/
-		void sigma_corr(int tmax, double* source, double* result) const noexcept;
+		double sigma_corr(int t, const double* source) const noexcept;
 
 		/**
 		* Computes the auto correlation for the sliding window.
@@ -84,6 +84,23 @@ namespace statistics {
 		*/
 		double auto_corr(int tmax, double* result) const noexcept;
 
+		/**
+		* Determines if the autocorrelation should be computed via the FFT.
+		*
+		* @param The number of elements to consider at maximum.
+		* @return True if the FFT is expected to be faster than the direct sum.
+		*/
+		bool use_fft(int tmax) const noexcept;
+
+		/**
+		* Computes the autocorrelation from the power spectrum of the zero-padded elements.
+		*
+		* @param The number of elements to consider at maximum.
+		* @param The normalization, i.e. the variance of the elements.
+		* @param The target where all autocorrelation values are stored.
+		*/
+		void auto_corr_fft(int tmax, double g0, double* result) const noexcept;
+
 	private:
 		std::vector<double> elements;
 		int lambda;
@@ -0,0 +1,142 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <functional>
+#include <random>
+#include <vector>
+#include "configuration.h"
+#include "measurement.h"
+#include "batchlattice.h"
+#include "logging.h"
+
+namespace physics {
+	/**
+	* Class that drives several independent (an-)harmonic oscillator simulations in lock-step.
+	* Every replica has its own random number stream and Metropolis decision.
+	*/
+	class BatchHarmonic final {
+	public:
+		/**
+		* Constructs a new BatchHarmonic simulation object.
+		*
+		* @param The configuration to use for all replicas, the seed is ignored.
+		* @param The seeds of the replicas, which also determine their number.
+		* @param The logger to write information and errors to.
+		*/
+		BatchHarmonic(const Configuration& configuration, const std::vector<int>& seeds, diagnostics::Logger& log) noexcept;
+
+		/**
+		* Runs the simulation of all replicas with all previously defined parameters.
+		*
+		* @param The callback to report progress to, which also receives the index of the replica.
+		* @return True if the simulation has been completed, false if the thermalization of a replica failed.
+		*/
+		bool run(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Gets the number of replicas.
+		*
+		* @return The number of replicas.
+		*/
+		int replicas() const noexcept;
+
+		/**
+		* Gets the acceptance rate of a replica.
+		*
+		* @param The index of the replica.
+		* @return The acceptance rate.
+		*/
+		double compute_acceptance(int replica) const noexcept;
+
+		/**
+		* Gets the average x values of a replica.
+		*
+		* @param The index of the replica.
+		* @return The average x values.
+		*/
+		double compute_x(int replica) const noexcept;
+
+		/**
+		* Gets the average squared x values of a replica.
+		*
+		* @param The index of the replica.
+		* @return The average squared x values.
+		*/
+		double compute_x_square(int replica) const noexcept;
+
+		/**
+		* Gets the number of integration steps per trajectory, which may have been adapted.
+		*
+		* @return The number of steps.
+		*/
+		int steps() const noexcept;
+
+		/**
+		* Gets the integration step size, which may have been adapted.
+		*
+		* @return The step size ε.
+		*/
+		double step_size() const noexcept;
+
+	protected:
+		/**
+		* Runs a single update step of all replicas and stores the Metropolis decisions.
+		*/
+		void step() noexcept;
+
+		/**
+		* Runs the initialization process, which is skipped if the step size is adapted.
+		*/
+		void init() noexcept;
+
+		/**
+		* Runs the thermalization process. The step size is shared by all replicas, hence it is
+		* adapted to the acceptance probability averaged over the replicas.
+		*
+		* @return True if the acceptance rates of all replicas are sufficient or the step size has been adapted, otherwise false.
+		*/
+		bool thermalize() noexcept;
+
+		/**
+		* Runs the measurement process, which also reports statistics.
+		*
+		* @param The callback to report progress to.
+		*/
+		void measure(std::function<void(int, const Measurement&)> report) noexcept;
+
+	private:
+		int ntherm;
+		int nmeas;
+		double target;
+		diagnostics::Logger& log;
+		std::vector<std::mt19937> rngs;
+		std::vector<std::uniform_real_distribution<double>> dists;
+		BatchLattice lattice;
+		std::vector<double> before;
+		std::vector<double> after;
+		std::vector<bool> accepted;
+		std::vector<double> xs;
+		std::vector<double> xsqs;
+		std::vector<double> actions;
+		std::vector<double> xsm;
+		std::vector<double> xsqm;
+		std::vector<double> acr;
+	};
+}
@@ -0,0 +1,172 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include "integrator.h"
+#include "acceleration.h"
+#include <random>
+#include <memory>
+#include <vector>
+
+namespace physics {
+	/**
+	* Lattice management class for several independent replicas that are evolved in lock-step.
+	* The values of a site are stored for all replicas next to each other (site-major, replica-minor),
+	* such that every loop over the sites advances all replicas with the same vector instructions.
+	*/
+	class BatchLattice final {
+	public:
+		/**
+		* Constructs a new BatchLattice object.
+		*
+		* @param The random number generators to use, one per replica.
+		* @param The number of temporal sites.
+		* @param The integrator for the equations of motion.
+		* @param The harmonic parameter, ω².
+		* @param The anharmonic parameter, λ.
+		* @param True if the momenta should use the Fourier accelerated kinetic mass.
+		*/
+		BatchLattice(std::vector<std::mt19937>& rngs, int nt, const Integrator& integrator, double omegasq, double lambda, bool accelerated = false) noexcept;
+
+		/**
+		* Cleans everything up.
+		*/
+		~BatchLattice() noexcept;
+
+		BatchLattice(const BatchLattice&) = delete;
+		BatchLattice& operator =(const BatchLattice&) = delete;
+
+		/**
+		* Gets the number of replicas.
+		*
+		* @return The number of replicas.
+		*/
+		int replicas() const noexcept;
+
+		/**
+		* Stores the current state of all replicas.
+		*/
+		void store() noexcept;
+
+		/**
+		* Restores the state of a single replica to the previously saved state.
+		*
+		* @param The index of the replica.
+		*/
+		void restore(int replica) noexcept;
+
+		/**
+		* Randomizes the momenta of all replicas.
+		*/
+		void randomize() noexcept;
+
+		/**
+		* Integrates the sites' values of all replicas by using their momenta.
+		*/
+		void integrate() noexcept;
+
+		/**
+		* Gets the number of integration steps per trajectory.
+		* @return The number of steps.
+		*/
+		int steps() const noexcept;
+
+		/**
+		* Gets the size of a single integration step.
+		* @return The step size ε.
+		*/
+		double step_size() const noexcept;
+
+		/**
+		* Changes the step size, where the number of steps is chosen such that the
+		* trajectory length is kept and the step size is not above the given one.
+		* @param The maximum step size ε.
+		*/
+		void step_size(double eps) noexcept;
+
+		/**
+		* Computes the value of the Hamilton operator of every replica.
+		*
+		* @param The target for the values of H, one per replica.
+		*/
+		void hamilton(double* result) const noexcept;
+
+		/**
+		* Computes the observables of every replica.
+		*
+		* @param The target for the average values of the sites.
+		* @param The target for the average squared values of the sites.
+		* @param The target for the average action values.
+		*/
+		void observables(double* x, double* xsquare, double* action) const noexcept;
+
+	protected:
+		/**
+		* Copies the boundary sites into the ghost cells of the periodic lattice.
+		*/
+		void refresh() const noexcept;
+
+		/**
+		* Performs a single integration step over all sites.
+		*
+		* @param The step size.
+		*/
+		void integrate_x(double eps) noexcept;
+
+		/**
+		* Performs a single integration step over all momenta.
+		*
+		* @param The step size.
+		* @param The shift of the sites for evaluating the force, which is 0 for the plain force.
+		* @param The part of the force.
+		*/
+		void integrate_p(double eps, double gradient, Force force) noexcept;
+
+		/**
+		* Changes the target by a part of the force, y -= ε F(x).
+		* @param The target y.
+		* @param The values x with valid ghost cells.
+		* @param The part of the force.
+		* @param The step size ε.
+		*/
+		void apply(double* target, const double* x, Force force, double eps) const noexcept;
+
+		/**
+		* Computes twice the action of every replica.
+		*
+		* @param The target for the values of 2 L, one per replica.
+		*/
+		void potential(double* result) const noexcept;
+
+	private:
+		std::vector<std::mt19937>& rngs;
+		std::vector<std::normal_distribution<double>> gauss;
+		int k;
+		int nt;
+		Integrator integrator;
+		double osq;
+		double lambda;
+		double* xv;
+		double* xbck;
+		double* xtmp;
+		double* pv;
+		double* vv;
+		std::unique_ptr<Acceleration> acceleration;
+	};
+}
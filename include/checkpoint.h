@@ -0,0 +1,163 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace io {
+	/**
+	* The version of the checkpoint format.
+	*/
+	const std::uint32_t checkpoint_version = 5;
+
+	/**
+	* Compact binary snapshot of a simulation, which is filled and read in the same order.
+	* Values are stored with their native representation, engines and distributions with
+	* their standard text representation, which restores them exactly.
+	*/
+	class Checkpoint final {
+	public:
+		/**
+		* Constructs a new empty checkpoint.
+		*/
+		Checkpoint() noexcept;
+
+		/**
+		* Reads a checkpoint from the given file.
+		*
+		* @param The name of the file to read.
+		* @return The checkpoint positioned at its first value.
+		*/
+		static Checkpoint load(const std::string& name);
+
+		/**
+		* Writes the checkpoint atomically, i.e. into a temporary file that replaces the given file.
+		*
+		* @param The name of the file to write.
+		* @return True if the checkpoint has been written, otherwise false.
+		*/
+		bool save(const std::string& name) const noexcept;
+
+		/**
+		* Appends a value.
+		*
+		* @param The value to store.
+		*/
+		template<typename T>
+		void put(const T& value) noexcept {
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be stored directly.");
+			append(&value, sizeof(T));
+		}
+
+		/**
+		* Appends an array of values.
+		*
+		* @param The values to store.
+		* @param The number of values.
+		*/
+		void put(const double* values, std::size_t count) noexcept;
+
+		/**
+		* Appends the state of a random number engine or distribution.
+		*
+		* @param The object to store.
+		*/
+		template<typename T>
+		void put_state(const T& state) noexcept {
+			std::ostringstream os;
+			os << state;
+			const auto text = os.str();
+			put(static_cast<std::uint64_t>(text.size()));
+			append(text.data(), text.size());
+		}
+
+		/**
+		* Reads the next value.
+		*
+		* @return The stored value.
+		*/
+		template<typename T>
+		T get() {
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read directly.");
+			T value;
+			extract(&value, sizeof(T));
+			return value;
+		}
+
+		/**
+		* Reads the next array of values.
+		*
+		* @param The target for the values.
+		* @param The number of values.
+		*/
+		void get(double* values, std::size_t count);
+
+		/**
+		* Reads the next array of values with the stored length.
+		*
+		* @param The target for the values, which is resized.
+		*/
+		void get(std::vector<double>& values);
+
+		/**
+		* Reads the state of a random number engine or distribution.
+		*
+		* @param The object to restore.
+		*/
+		template<typename T>
+		void get_state(T& state) {
+			const auto length = get<std::uint64_t>();
+			std::string text(static_cast<std::size_t>(length), '\0');
+			extract(&text[0], text.size());
+			std::istringstream is { text };
+			is >> state;
+
+			if (is.fail())
+				throw std::runtime_error("The checkpoint contains an invalid random number state.");
+		}
+
+	protected:
+		/**
+		* Appends raw bytes.
+		*
+		* @param The bytes to append.
+		* @param The number of bytes.
+		*/
+		void append(const void* bytes, std::size_t count) noexcept;
+
+		/**
+		* Reads raw bytes.
+		*
+		* @param The target for the bytes.
+		* @param The number of bytes.
+		*/
+		void extract(void* bytes, std::size_t count);
+
+	private:
+		std::vector<char> data;
+		std::size_t offset;
+	};
+}
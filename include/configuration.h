@@ -18,6 +18,8 @@
 */
 
 #pragma once
+#include "integrator.h"
+#include "philox.h"
 #include <iostream>
 
 namespace physics {
@@ -58,18 +60,73 @@ namespace physics {
 		* The seed for the random number generator.
 		*/
 		int seed;
+		/**
+		* The scheme for integrating the equations of motion.
+		*/
+		Scheme integrator;
+		/**
+		* The tuning parameter λ of the second order Omelyan integrator.
+		*/
+		double omelyan;
+		/**
+		* The number of steps of the anharmonic force per update of the sites, 0 for no splitting.
+		*/
+		int substeps;
+		/**
+		* True if the kinetic mass is Fourier accelerated.
+		*/
+		bool fourier;
+		/**
+		* The target acceptance rate for adapting the step size during the thermalization, 0 to keep it fixed.
+		*/
+		double target;
+		/**
+		* The engine of the random numbers.
+		*/
+		numerics::Engine engine;
+		/**
+		* The number of dimensions, where every dimension has Nt sites.
+		*/
+		int dimensions;
+		/**
+		* The number of domains of the lattice, each integrated by its own thread.
+		*/
+		int domains;
 
 		friend std::ostream& operator <<(std::ostream& os, const Configuration& config) {
 			using std::endl;
 
 			os << "Nt    = " << config.nt << endl;
+
+			if (config.dimensions > 1)
+				os << "Dim   = " << config.dimensions << endl;
+
 			os << "ω²    = " << config.omega_square << endl;
 			os << "λ     = " << config.lambda << endl;
 			os << "Nmeas = " << config.nmeas << endl;
 			os << "Nterm = " << config.ntherm << endl;
 			os << "τ     = " << config.tau << endl;
 			os << "Nstep = " << config.nstep << endl;
-			os << "Seed  = " << config.seed;
+			os << "Seed  = " << config.seed << endl;
+			os << "Int   = " << Integrator::name(config.integrator);
+
+			if (config.integrator == Scheme::omelyan2)
+				os << " (λ = " << config.omelyan << ")";
+
+			if (config.substeps > 0)
+				os << endl << "Nsub  = " << config.substeps;
+
+			if (config.fourier)
+				os << endl << "Mass  = Fourier accelerated";
+
+			if (config.target > 0.0)
+				os << endl << "Acc   = " << config.target << " (adaptive step size)";
+
+			if (config.engine != numerics::Engine::mt19937)
+				os << endl << "Rng   = " << numerics::Philox::name(config.engine);
+
+			if (config.domains > 1)
+				os << endl << "Dom   = " << config.domains;
 
 			return os;
 		}
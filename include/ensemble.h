@@ -0,0 +1,151 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <iostream>
+#include <functional>
+#include <vector>
+#include "configuration.h"
+#include "measurement.h"
+#include "autocorrelation.h"
+#include "logging.h"
+
+namespace physics {
+	/**
+	* The statistics gathered by a single Markov chain, which are NaN if its thermalization failed.
+	*/
+	struct ChainResult {
+	public:
+		double acceptance;
+		double x;
+		double x_square;
+		statistics::Observable<double> tau;
+		int steps;
+		bool failed;
+	};
+
+	/**
+	* Runs several independent Harmonic simulations concurrently and merges their statistics.
+	*/
+	class Ensemble final {
+	public:
+		/**
+		* Constructs a new Ensemble of Markov chains.
+		*
+		* @param The configuration to use for every chain, the seed is used to derive the chain seeds.
+		* @param The number of independent chains.
+		* @param The number of threads to use, 0 uses the hardware concurrency.
+		* @param The number of chains that are evolved in lock-step by a single thread.
+		* @param The maximum lag that is tracked for the autocorrelation analysis.
+		* @param The logger to write errors to.
+		*/
+		Ensemble(const Configuration& configuration, int chains, int threads, int batch, int window, diagnostics::Logger& log) noexcept;
+
+		/**
+		* Runs all chains, where each chain is processed by a single thread at a time.
+		*
+		* @param The callback to report progress to, which also receives the index of the chain.
+		* @return True if all chains have been completed, false if the thermalization of a chain failed.
+		*/
+		bool run(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Gets the seed that is used for the given chain.
+		*
+		* @param The index of the chain.
+		* @return The decorrelated seed of the chain.
+		*/
+		int seed(int chain) const noexcept;
+
+		/**
+		* Gets the results of the individual chains.
+		*
+		* @return The statistics per chain.
+		*/
+		const std::vector<ChainResult>& results() const noexcept;
+
+		/**
+		* Gets the acceptance rate combined over all chains.
+		*
+		* @return The mean acceptance rate and its between-chain error.
+		*/
+		statistics::Observable<double> compute_acceptance() const noexcept;
+
+		/**
+		* Gets the average x values combined over all chains.
+		*
+		* @return The mean of x and its between-chain error.
+		*/
+		statistics::Observable<double> compute_x() const noexcept;
+
+		/**
+		* Gets the average squared x values combined over all chains.
+		*
+		* @return The mean of x² and its between-chain error.
+		*/
+		statistics::Observable<double> compute_x_square() const noexcept;
+
+		/**
+		* Gets the integrated autocorrelation time combined over all chains.
+		*
+		* @return The mean autocorrelation time and its error.
+		*/
+		statistics::Observable<double> compute_tau() const noexcept;
+
+		/**
+		* Creates the result of a chain whose thermalization failed.
+		*
+		* @param The number of integration steps per trajectory.
+		* @return The result with NaN statistics.
+		*/
+		static ChainResult failure(int steps) noexcept;
+
+	protected:
+		/**
+		* Runs every chain with its own Harmonic simulation.
+		*
+		* @param The callback to report progress to.
+		*/
+		void run_chains(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Runs the chains in batches of BatchHarmonic simulations.
+		*
+		* @param The callback to report progress to.
+		*/
+		void run_batches(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Combines a value of all chains to a mean and its standard error.
+		*
+		* @param The selector of the value.
+		* @return The combined value.
+		*/
+		statistics::Observable<double> combine(std::function<double(const ChainResult&)> select) const noexcept;
+
+	private:
+		Configuration configuration;
+		int chains;
+		int threads;
+		int batch;
+		int window;
+		diagnostics::Logger& log;
+		std::vector<ChainResult> chain_results;
+	};
+}
@@ -0,0 +1,97 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+namespace numerics {
+	/**
+	* Fast Fourier transform of real-valued sequences. Lengths that are a power of 2 use a radix-2
+	* transform of half the length, other lengths Bluestein's chirp-z algorithm on top of it.
+	*/
+	class FourierTransform final {
+	public:
+		/**
+		* Constructs a new Fourier transform for the given length.
+		*
+		* @param The number of real values.
+		*/
+		explicit FourierTransform(std::size_t size) noexcept;
+
+		/**
+		* Gets the number of real values that are transformed.
+		*
+		* @return The length of the transform.
+		*/
+		std::size_t size() const noexcept;
+
+		/**
+		* Computes the (unnormalized) discrete Fourier transform of real values.
+		*
+		* @param The size() real values to transform.
+		* @param The target for the size() / 2 + 1 non-redundant coefficients.
+		*/
+		void forward(const double* input, std::complex<double>* output) noexcept;
+
+		/**
+		* Computes the inverse transform of the non-redundant coefficients, including the 1 / size() factor.
+		*
+		* @param The size() / 2 + 1 coefficients of a real sequence.
+		* @param The target for the size() real values.
+		*/
+		void inverse(const std::complex<double>* input, double* output) noexcept;
+
+		/**
+		* Gets the smallest power of 2 that is not below the given number.
+		*
+		* @param The number to round up.
+		* @return The rounded number.
+		*/
+		static std::size_t next_power_of_two(std::size_t n) noexcept;
+
+	protected:
+		/**
+		* Performs an in-place complex transform of half the length.
+		*
+		* @param The size() / 2 complex values to transform.
+		* @param True if the backward transform should be computed.
+		*/
+		void transform(std::complex<double>* data, bool backward) const noexcept;
+
+		/**
+		* Performs an in-place complex transform of the first size() values of the buffer
+		* by a convolution with the chirp.
+		*/
+		void bluestein() noexcept;
+
+	private:
+		std::size_t n;
+		std::size_t m;
+		bool radix;
+		std::vector<std::size_t> bitrev;
+		std::vector<std::complex<double>> twiddles;
+		std::vector<std::complex<double>> conjugates;
+		std::vector<std::complex<double>> rotations;
+		std::vector<std::complex<double>> buffer;
+		std::vector<std::complex<double>> chirp;
+		std::vector<std::complex<double>> kernel;
+	};
+}
@@ -0,0 +1,135 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+namespace numerics {
+	/**
+	* Generator of standard normal values in bulk. The uniform values are drawn from several xoshiro256+
+	* generators side by side and transformed via Box-Muller, where the logarithm, the sine and the
+	* cosine are computed by polynomials, such that all loops over a block of values vectorize.
+	*/
+	class Gaussian final {
+	public:
+		/**
+		* The number of generators that are advanced together.
+		*/
+		static const int lanes = 16;
+
+		/**
+		* The number of pairs of values that are transformed together.
+		*/
+		static const int block_size = 64;
+
+		/**
+		* Constructs a new generator with a fixed state.
+		*/
+		Gaussian() noexcept;
+
+		/**
+		* Constructs a new generator, whose state is drawn from another engine.
+		*
+		* @param The engine that yields 32 random bits per call.
+		*/
+		template<typename Engine>
+		explicit Gaussian(Engine& engine) noexcept {
+			seed(engine);
+		}
+
+		/**
+		* Draws the state of the generator from another engine.
+		*
+		* @param The engine that yields 32 random bits per call.
+		*/
+		template<typename Engine>
+		void seed(Engine& engine) noexcept {
+			for (auto& words : state) {
+				for (auto& word : words) {
+					const auto hi = static_cast<std::uint64_t>(engine() & 0xffffffff);
+					word = (hi << 32) | static_cast<std::uint64_t>(engine() & 0xffffffff);
+				}
+			}
+
+			repair();
+		}
+
+		/**
+		* Fills an array with standard normal values.
+		*
+		* @param The target for the values.
+		* @param The number of values.
+		*/
+		void operator()(double* target, int n) noexcept;
+
+		/**
+		* Transforms pairs of random words to pairs of standard normal values via Box-Muller.
+		* The upper 52 bits of the first word give the radius, the upper 54 bits of the
+		* second word give the angle.
+		*
+		* @param The target for the values, where pair k is stored at 2k and 2k + 1.
+		* @param The random words of the radii.
+		* @param The random words of the angles.
+		* @param The number of values, which may be odd, i.e. only the first value of the last pair is used.
+		*/
+		static void transform(double* target, const std::uint64_t* radii, const std::uint64_t* angles, int n) noexcept;
+
+		friend bool operator ==(const Gaussian& a, const Gaussian& b) noexcept {
+			return a.state == b.state;
+		}
+
+		friend bool operator !=(const Gaussian& a, const Gaussian& b) noexcept {
+			return !(a == b);
+		}
+
+		friend std::ostream& operator <<(std::ostream& os, const Gaussian& gaussian) {
+			for (const auto& words : gaussian.state)
+				for (const auto word : words)
+					os << word << ' ';
+
+			return os;
+		}
+
+		friend std::istream& operator >>(std::istream& is, Gaussian& gaussian) {
+			for (auto& words : gaussian.state)
+				for (auto& word : words)
+					is >> word;
+
+			return is;
+		}
+
+	private:
+		/**
+		* Draws the random words of a block.
+		*
+		* @param The target for the words of the radii.
+		* @param The target for the words of the angles.
+		*/
+		void next(std::uint64_t* radii, std::uint64_t* angles) noexcept;
+
+		/**
+		* Replaces a state that consists of zeros only, which would never change.
+		*/
+		void repair() noexcept;
+
+		std::array<std::array<std::uint64_t, lanes>, 4> state;
+	};
+}
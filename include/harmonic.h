@@ -21,7 +21,9 @@
 #include <iostream>
 #include <functional>
 #include "configuration.h"
+#include "measurement.h"
 #include "lattice.h"
+#include "logging.h"
 
 namespace physics {
 	/**
@@ -33,17 +35,42 @@ namespace physics {
 		* Constructs a new Harmonic simulation object.
 		*
 		* @param The configuration to use for the simulation.
-		* @param The stream to write information to.
-		* @param The stream to write errors to.
+		* @param The logger to write information and errors to.
 		*/
-		Harmonic(const Configuration& configuration, std::ostream& info, std::ostream& warn) noexcept;
+		Harmonic(const Configuration& configuration, diagnostics::Logger& log) noexcept;
 
 		/**
 		* Runs a simulation with all previously defined parameters.
 		*
 		* @param The callback to report progress to.
+		* @return True if the simulation has been completed, false if the thermalization failed.
 		*/
-		void run(std::function<void(int, double, double, double)> report) noexcept;
+		bool run(std::function<void(const Measurement&)> report) noexcept;
+
+		/**
+		* Runs a simulation, which is checkpointed after the thermalization and periodically during the measurements.
+		* A simulation that has been restored from a checkpoint continues with the next measurement.
+		*
+		* @param The callback to report progress to.
+		* @param The number of measurements between two checkpoints, 0 to disable periodic checkpoints.
+		* @param The callback that writes a checkpoint.
+		* @return True if the simulation has been completed, false if the thermalization failed.
+		*/
+		bool run(std::function<void(const Measurement&)> report, int every, std::function<void()> checkpoint) noexcept;
+
+		/**
+		* Stores the state of the simulation in a checkpoint, preceded by the parameters that determine the trajectories.
+		*
+		* @param The checkpoint to append to.
+		*/
+		void save(io::Checkpoint& checkpoint) const noexcept;
+
+		/**
+		* Restores the state of the simulation from a checkpoint, which must have been written with the same parameters.
+		*
+		* @param The checkpoint to read from.
+		*/
+		void load(io::Checkpoint& checkpoint);
 
 		/**
 		* Gets the current acceptance rate.
@@ -66,6 +93,20 @@ namespace physics {
 		*/
 		double compute_x_square() const noexcept;
 
+		/**
+		* Gets the number of integration steps per trajectory, which may have been adapted.
+		*
+		* @return The number of steps.
+		*/
+		int steps() const noexcept;
+
+		/**
+		* Gets the integration step size, which may have been adapted.
+		*
+		* @return The step size ε.
+		*/
+		double step_size() const noexcept;
+
 	protected:
 		/**
 		* Determines if the given delta should be accepted.
@@ -83,32 +124,43 @@ namespace physics {
 		bool step() noexcept;
 
 		/**
-		* Runs the initialization process.
+		* Runs the initialization process, which is skipped if the step size is adapted.
 		*/
 		void init() noexcept;
 
 		/**
-		* Runs the thermalization process.
+		* Runs the thermalization process, which adapts the step size if a target acceptance is given.
+		*
+		* @return True if the acceptance rate is sufficient or the step size has been adapted, otherwise false.
 		*/
-		void thermalize() noexcept;
+		bool thermalize() noexcept;
 
 		/**
 		* Runs the measurement process, which also reports statistics.
 		*
 		* @param The callback to report progress to.
+		* @param The number of measurements between two checkpoints, 0 to disable periodic checkpoints.
+		* @param The callback that writes a checkpoint.
 		*/
-		void measure(std::function<void(int, double, double, double)> report) noexcept;
+		void measure(std::function<void(const Measurement&)> report, int every, std::function<void()> checkpoint) noexcept;
 
 	private:
 		int ntherm;
 		int nmeas;
-		std::ostream& info;
-		std::ostream& warn;
+		int done;
+		bool resumed;
+		double target;
+		double delta;
+		diagnostics::Logger& log;
 		std::mt19937 rng;
 		std::uniform_real_distribution<double> dist;
+		numerics::Philox philox;
+		bool counter;
+		std::uint64_t trajectory;
 		Lattice lattice;
 		double xsm;
 		double xsqm;
 		double acr;
+		Configuration configuration;
 	};
 }
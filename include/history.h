@@ -0,0 +1,354 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include "configuration.h"
+#include "measurement.h"
+#include "ringbuffer.h"
+
+namespace io {
+	/**
+	* The version of the binary history format.
+	*/
+	const std::uint32_t binary_version = 1;
+
+	/**
+	* The fixed-width header at the beginning of a binary history file.
+	*/
+	struct FileHeader {
+	public:
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t chunk_capacity;
+		std::int32_t nt;
+		std::int32_t nmeas;
+		std::int32_t ntherm;
+		std::int32_t nstep;
+		std::int32_t seed;
+		std::int32_t integrator;
+		double omega_square;
+		double lambda;
+		double tau;
+		double omelyan;
+		std::int32_t substeps;
+		std::int32_t fourier;
+		double target;
+		std::int32_t engine;
+		std::int32_t dimensions;
+		char padding[32];
+	};
+
+	/**
+	* The header in front of every chunk of a binary history file.
+	* A chunk stores the columns n (int64), x, x², action (double) and accepted (uint8, padded to 8 bytes).
+	*/
+	struct ChunkHeader {
+	public:
+		std::uint64_t count;
+		std::uint64_t reserved;
+	};
+
+	/**
+	* A read-only view on a contiguous column of values.
+	*/
+	template<typename T>
+	struct Column {
+	public:
+		const T* data;
+		std::size_t size;
+
+		const T& operator [](std::size_t index) const noexcept {
+			return data[index];
+		}
+
+		const T* begin() const noexcept {
+			return data;
+		}
+
+		const T* end() const noexcept {
+			return data + size;
+		}
+	};
+
+	/**
+	* Base class for writing the measurement history.
+	*/
+	class HistoryWriter {
+	public:
+		virtual ~HistoryWriter() noexcept {
+		}
+
+		/**
+		* Appends a measurement to the history.
+		*
+		* @param The measurement to write.
+		*/
+		virtual void write(const physics::Measurement& measurement) noexcept = 0;
+
+		/**
+		* Writes all buffered measurements to the file.
+		*/
+		virtual void flush() noexcept = 0;
+
+		/**
+		* Flushes and closes the file.
+		*/
+		virtual void close() noexcept = 0;
+
+		/**
+		* Gets the size of the file, which includes buffered measurements only after a flush.
+		*
+		* @return The number of bytes that have been written.
+		*/
+		virtual std::uint64_t position() noexcept = 0;
+	};
+
+	/**
+	* Writes the history as tab-separated text.
+	*/
+	class TextWriter final : public HistoryWriter {
+	public:
+		/**
+		* Constructs a new text writer.
+		*
+		* @param The name of the file to write to.
+		* @param The size of an existing file to continue, 0 to create a new file.
+		*/
+		explicit TextWriter(const std::string& name, std::uint64_t offset = 0) noexcept;
+
+		void write(const physics::Measurement& measurement) noexcept;
+
+		void flush() noexcept;
+
+		void close() noexcept;
+
+		std::uint64_t position() noexcept;
+
+	private:
+		std::ofstream output;
+	};
+
+	/**
+	* Writes the history in chunks of fixed-width columns.
+	*/
+	class BinaryWriter final : public HistoryWriter {
+	public:
+		/**
+		* Constructs a new binary writer and writes the header.
+		*
+		* @param The name of the file to write to.
+		* @param The configuration of the simulation.
+		* @param The size of an existing file to continue, 0 to create a new file.
+		* @param The maximum number of measurements per chunk.
+		*/
+		BinaryWriter(const std::string& name, const physics::Configuration& configuration, std::uint64_t offset = 0, std::size_t capacity = 16384) noexcept;
+
+		~BinaryWriter() noexcept;
+
+		void write(const physics::Measurement& measurement) noexcept;
+
+		void flush() noexcept;
+
+		void close() noexcept;
+
+		std::uint64_t position() noexcept;
+
+	private:
+		std::ofstream output;
+		std::size_t capacity;
+		std::vector<std::int64_t> index;
+		std::vector<double> x;
+		std::vector<double> x_square;
+		std::vector<double> action;
+		std::vector<std::uint8_t> accepted;
+	};
+
+	/**
+	* Forwards the measurements to another writer, which runs on a dedicated thread.
+	*/
+	class AsyncWriter final : public HistoryWriter {
+	public:
+		/**
+		* Constructs a new asynchronous writer and starts its thread.
+		*
+		* @param The writer that performs the actual output.
+		* @param The number of measurements that can be queued before the producer has to wait.
+		*/
+		explicit AsyncWriter(std::unique_ptr<HistoryWriter> target, std::size_t capacity = 4096) noexcept;
+
+		~AsyncWriter() noexcept;
+
+		void write(const physics::Measurement& measurement) noexcept;
+
+		void flush() noexcept;
+
+		void close() noexcept;
+
+		std::uint64_t position() noexcept;
+
+	protected:
+		/**
+		* The loop of the writer thread, which drains the queue until closed.
+		*/
+		void drain() noexcept;
+
+	private:
+		std::unique_ptr<HistoryWriter> target;
+		concurrency::RingBuffer<physics::Measurement> queue;
+		std::size_t pushed;
+		std::atomic<std::size_t> written;
+		std::atomic<bool> stopping;
+		std::thread worker;
+	};
+
+	/**
+	* Creates a writer for the given format.
+	*
+	* @param The format of the file, either text or binary.
+	* @param The name of the file to write to.
+	* @param The configuration of the simulation.
+	* @param The size of an existing file to continue, which is truncated to it, 0 to create a new file.
+	* @return The writer, which performs the output on its own thread, or nullptr if the format is unknown.
+	*/
+	std::unique_ptr<HistoryWriter> create_writer(const std::string& format, const std::string& name, const physics::Configuration& configuration, std::uint64_t offset = 0) noexcept;
+
+	/**
+	* Maps a binary history file into memory and gives access to its columns without copying.
+	*/
+	class HistoryReader final {
+	public:
+		/**
+		* Opens and maps the given file.
+		*
+		* @param The name of the binary history file.
+		*/
+		explicit HistoryReader(const std::string& name);
+
+		/**
+		* Unmaps the file.
+		*/
+		~HistoryReader() noexcept;
+
+		HistoryReader(const HistoryReader&) = delete;
+		HistoryReader& operator =(const HistoryReader&) = delete;
+
+		/**
+		* Gets the header of the file.
+		*
+		* @return The file header.
+		*/
+		const FileHeader& header() const noexcept;
+
+		/**
+		* Gets the configuration that has been stored in the header.
+		*
+		* @return The configuration of the simulation.
+		*/
+		physics::Configuration configuration() const noexcept;
+
+		/**
+		* Gets the number of (complete) chunks in the file.
+		*
+		* @return The number of chunks.
+		*/
+		std::size_t chunks() const noexcept;
+
+		/**
+		* Gets the total number of measurements in the file.
+		*
+		* @return The number of measurements.
+		*/
+		std::size_t size() const noexcept;
+
+		/**
+		* Gets the measurement indices of a chunk.
+		*
+		* @param The index of the chunk.
+		* @return The column of n.
+		*/
+		Column<std::int64_t> index(std::size_t chunk) const noexcept;
+
+		/**
+		* Gets the average x values of a chunk.
+		*
+		* @param The index of the chunk.
+		* @return The column of x.
+		*/
+		Column<double> x(std::size_t chunk) const noexcept;
+
+		/**
+		* Gets the average squared x values of a chunk.
+		*
+		* @param The index of the chunk.
+		* @return The column of x².
+		*/
+		Column<double> x_square(std::size_t chunk) const noexcept;
+
+		/**
+		* Gets the average action values of a chunk.
+		*
+		* @param The index of the chunk.
+		* @return The column of the action.
+		*/
+		Column<double> action(std::size_t chunk) const noexcept;
+
+		/**
+		* Gets the acceptance flags of a chunk.
+		*
+		* @param The index of the chunk.
+		* @return The column of the accept flags (0 or 1).
+		*/
+		Column<std::uint8_t> accepted(std::size_t chunk) const noexcept;
+
+	protected:
+		/**
+		* Releases the mapped memory.
+		*/
+		void unmap() noexcept;
+
+		/**
+		* Gets the column with the given offset in units of the chunk length.
+		*
+		* @param The index of the chunk.
+		* @param The offset of the column in bytes per measurement.
+		* @return The column.
+		*/
+		template<typename T>
+		Column<T> column(std::size_t chunk, std::size_t offset) const noexcept {
+			const auto count = counts[chunk];
+			const auto base = data + offsets[chunk] + sizeof(ChunkHeader);
+			return Column<T> { reinterpret_cast<const T*>(base + offset * count), count };
+		}
+
+	private:
+		const char* data;
+		std::size_t length;
+		std::vector<std::size_t> offsets;
+		std::vector<std::size_t> counts;
+		std::size_t total;
+	};
+}
@@ -0,0 +1,199 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+
+namespace physics {
+	/**
+	* The available schemes for integrating the equations of motion.
+	*/
+	enum class Scheme : int {
+		leapfrog = 0,
+		omelyan2 = 1,
+		omelyan4 = 2,
+		force_gradient = 3
+	};
+
+	/**
+	* The parts of the force, which can be integrated on separate time scales.
+	*/
+	enum class Force : int {
+		full = 0,
+		harmonic = 1,
+		anharmonic = 2
+	};
+
+	/**
+	* A single update of an integration scheme.
+	*/
+	struct Operation {
+	public:
+		/**
+		* True for an update of the sites x += c p, false for an update of the momenta p -= c F(x').
+		*/
+		bool drift;
+		/**
+		* The step size c of the update.
+		*/
+		double coefficient;
+		/**
+		* The shift g of the sites for the force, x' = x - g F(x), which is 0 for a plain force.
+		*/
+		double gradient;
+		/**
+		* The part of the force F that is used by an update of the momenta.
+		*/
+		Force force;
+	};
+
+	/**
+	* Symplectic integration scheme, which is unrolled into a sequence of updates for a whole trajectory.
+	* With substeps the force is split (Sexton, Weingarten): the outer level integrates the harmonic part
+	* and every update of the sites is replaced by an inner integration of the anharmonic part.
+	*/
+	class Integrator final {
+	public:
+		/**
+		* Constructs a new integrator.
+		*
+		* @param The scheme to use.
+		* @param The number of integration steps.
+		* @param The integration trajectory length.
+		* @param The tuning parameter λ of the second order Omelyan scheme.
+		* @param The number of inner steps per update of the sites, 0 for a single level with the full force.
+		*/
+		Integrator(Scheme scheme, int nstep, double tau, double parameter = default_parameter, int substeps = 0) noexcept;
+
+		/**
+		* Gets the scheme of the integrator.
+		*
+		* @return The integration scheme.
+		*/
+		Scheme scheme() const noexcept;
+
+		/**
+		* Gets the number of integration steps.
+		*
+		* @return The number of steps.
+		*/
+		int steps() const noexcept;
+
+		/**
+		* Gets the number of inner steps per update of the sites.
+		*
+		* @return The number of substeps, 0 without splitting.
+		*/
+		int substeps() const noexcept;
+
+		/**
+		* Gets the integration trajectory length.
+		*
+		* @return The trajectory length τ.
+		*/
+		double trajectory_length() const noexcept;
+
+		/**
+		* Creates the same scheme with a different number of steps for the same trajectory length.
+		*
+		* @param The new number of integration steps.
+		* @return The resized integrator.
+		*/
+		Integrator resize(int nstep) const noexcept;
+
+		/**
+		* Gets the size of a single integration step of the outer level.
+		*
+		* @return The step size ε.
+		*/
+		double step_size() const noexcept;
+
+		/**
+		* Gets the updates of a whole trajectory.
+		*
+		* @return The sequence of updates.
+		*/
+		const std::vector<Operation>& operations() const noexcept;
+
+		/**
+		* Gets the number of evaluations of a part of the force per trajectory.
+		*
+		* @param The part of the force.
+		* @return The number of force evaluations.
+		*/
+		int force_evaluations(Force force = Force::full) const noexcept;
+
+		/**
+		* Gets the name of a scheme.
+		*
+		* @param The scheme.
+		* @return The name of the scheme.
+		*/
+		static const char* name(Scheme scheme) noexcept;
+
+		/**
+		* Finds the scheme with the given name.
+		*
+		* @param The name of the scheme.
+		* @param The target for the scheme.
+		* @return True if the scheme has been found, otherwise false.
+		*/
+		static bool parse(const std::string& name, Scheme& scheme) noexcept;
+
+		/**
+		* The value of λ for the second order minimum norm scheme.
+		*/
+		static constexpr double default_parameter = 0.1931833275037836;
+
+		/**
+		* The largest number of steps that is chosen for a given step size.
+		*/
+		static constexpr int max_steps = 65536;
+
+	protected:
+		/**
+		* Unrolls the scheme over a given length of a level.
+		*
+		* @param The level, where 0 is the outermost level.
+		* @param The integration length.
+		* @param The number of steps.
+		*/
+		void unroll(int level, double length, int steps) noexcept;
+
+		/**
+		* Appends an update, which is merged with the previous update if possible.
+		*
+		* @param True for an update of the sites, false for the momenta.
+		* @param The step size.
+		* @param The shift of the sites.
+		* @param The part of the force.
+		*/
+		void append(bool drift, double coefficient, double gradient, Force force) noexcept;
+
+	private:
+		Scheme kind;
+		int nstep;
+		int nsub;
+		double tau;
+		double eps;
+		double parameter;
+		std::vector<Operation> ops;
+	};
+}
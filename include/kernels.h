@@ -0,0 +1,239 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+
+namespace physics {
+	/**
+	* Vectorized loops over the sites of a lattice. The loops also work on sub-ranges;
+	* arrays of values x need valid neighbours x[-1] and x[n] of the range.
+	*/
+	namespace kernels {
+		/**
+		* The alignment of the site arrays in bytes.
+		*/
+		const int alignment = 64;
+
+		/**
+		* The number of padding values in front of and after the sites of an array.
+		*/
+		const int halo = alignment / sizeof(double);
+
+		/**
+		* The form of the potential, where the anharmonic terms are only evaluated for the quartic form.
+		*/
+		enum class Form : int {
+			harmonic = 0,
+			quartic = 1
+		};
+
+		/**
+		* Drifts all sites of a periodic lattice, y = x + ε v, and kicks the momenta by the force of the new sites.
+		* The ghost cells of the target are set.
+		*
+		* @param The target for the new values y, which may be x.
+		* @param The values x.
+		* @param The velocities v.
+		* @param The momenta p.
+		* @param The step size ε of the sites.
+		* @param The step size of the momenta.
+		* @param The diagonal coupling 2 + ω².
+		* @param The anharmonic coupling λ.
+		* @param The number of sites per dimension, which is ignored for a fixed number of sites.
+		* @return The value of Σ p² of the new momenta.
+		*/
+		typedef double (*SweepKernel)(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n);
+
+		/**
+		* Drifts all sites of a periodic lattice in place, x += ε v, and computes twice the action of the new sites.
+		* The ghost cells are set.
+		*
+		* @param The values x.
+		* @param The velocities v.
+		* @param The step size ε.
+		* @param The diagonal coupling 2 + ω².
+		* @param The anharmonic coupling λ.
+		* @param The number of sites per dimension, which is ignored for a fixed number of sites.
+		* @return The value of 2 L of the new sites.
+		*/
+		typedef double (*SweepPotentialKernel)(double* x, const double* v, double ex, double osq, double lambda, int n);
+
+		/**
+		* Kicks the momenta of all sites of a periodic lattice, see kick.
+		*/
+		typedef double (*KickKernel)(double* p, const double* x, double osq, double lambda, double eps, int n);
+
+		/**
+		* Computes twice the action of all sites of a periodic lattice, see potential.
+		*/
+		typedef double (*PotentialKernel)(const double* x, double osq, double lambda, int n);
+
+		/**
+		* Drifts the slices [first, last) of the last dimension of a periodic lattice, i.e. single sites for one
+		* dimension, and kicks the momenta of the slices in between, whose neighbours have drifted, see SweepKernel.
+		* The first and the last slice are kicked once the neighbouring ranges have drifted, too.
+		* For one dimension the ranges with the first and the last site set the ghost cells of the target.
+		*/
+		typedef double (*SweepSlicesKernel)(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n, int first, int last);
+
+		/**
+		* Drifts the slices [first, last) in place and computes twice the action of the slices in between, see SweepPotentialKernel.
+		*/
+		typedef double (*SweepPotentialSlicesKernel)(double* x, const double* v, double ex, double osq, double lambda, int n, int first, int last);
+
+		/**
+		* Kicks the momenta of the slices [first, last), see kick.
+		*/
+		typedef double (*KickSlicesKernel)(double* p, const double* x, double osq, double lambda, double eps, int n, int first, int last);
+
+		/**
+		* Computes twice the action of the slices [first, last), see potential.
+		*/
+		typedef double (*PotentialSlicesKernel)(const double* x, double osq, double lambda, int n, int first, int last);
+
+		/**
+		* The kernels for all sites of a lattice, which are instantiated for the form of the potential
+		* and for a few fixed numbers of sites, such that the loops are known at compile time.
+		* A lattice with d > 1 dimensions consists of rows, i.e. the contiguous first dimension, whose
+		* 2 d point stencil visits the rows in tiles, such that the neighbouring rows are still in the cache.
+		* The diagonal coupling is then 2 d + ω² and no ghost cells are used.
+		* The kernels for slices work on a part of the lattice, such that the lattice can be decomposed into domains.
+		*/
+		struct Specialization {
+			SweepKernel sweep;
+			SweepPotentialKernel sweep_potential;
+			KickKernel kick;
+			PotentialKernel potential;
+			SweepSlicesKernel sweep_slices;
+			SweepPotentialSlicesKernel sweep_potential_slices;
+			KickSlicesKernel kick_slices;
+			PotentialSlicesKernel potential_slices;
+			Form form;
+			int sites;
+		};
+
+		/**
+		* Allocates an aligned array of sites including the halo.
+		*
+		* @param The number of sites.
+		* @param True if the array is set to zero, otherwise the sites are left to their first writer.
+		* @return The pointer to the first site, with at least one ghost cell before and after.
+		*/
+		double* allocate(int n, bool clear = true) noexcept;
+
+		/**
+		* Releases an array previously obtained from allocate.
+		*
+		* @param The pointer to the first site.
+		*/
+		void release(double* sites) noexcept;
+
+		/**
+		* Gets the name of the instruction set that is used by the kernels.
+		*
+		* @return The name of the instruction set.
+		*/
+		const char* instruction_set() noexcept;
+
+		/**
+		* Selects the kernels for a lattice, i.e. the harmonic form for λ = 0 and the quartic form otherwise.
+		*
+		* @param The number of sites per dimension.
+		* @param The anharmonic coupling λ.
+		* @param The number of dimensions, at most 4.
+		* @return The kernels, whose number of sites is 0 unless it is fixed at compile time.
+		*/
+		Specialization specialize(int n, double lambda, int dimensions = 1) noexcept;
+
+		/**
+		* Moves the values along the momenta, y = x + ε p, where y may be x.
+		*
+		* @param The target for the new values y.
+		* @param The values x.
+		* @param The momenta p.
+		* @param The step size ε.
+		* @param The number of sites.
+		*/
+		void drift(double* y, const double* x, const double* p, double eps, int n) noexcept;
+
+		/**
+		* Changes the momenta by the force, p -= ε F(x).
+		*
+		* @param The momenta p.
+		* @param The values x including valid neighbours x[-stride] and x[n + stride - 1].
+		* @param The diagonal coupling 2 + ω².
+		* @param The anharmonic coupling λ.
+		* @param The step size ε.
+		* @param The number of sites.
+		* @param The distance between neighbouring sites in the arrays.
+		* @return The value of Σ p² of the new momenta.
+		*/
+		double kick(double* p, const double* x, double osq, double lambda, double eps, int n, int stride = 1) noexcept;
+
+		/**
+		* Changes the momenta by the anharmonic part of the force only, p -= ε 4λ x³.
+		*
+		* @param The momenta p.
+		* @param The values x.
+		* @param The anharmonic coupling λ.
+		* @param The step size ε.
+		* @param The number of sites.
+		* @return The value of Σ p² of the new momenta.
+		*/
+		double kick_anharmonic(double* p, const double* x, double lambda, double eps, int n) noexcept;
+
+		/**
+		* Computes the sum of the squared momenta.
+		*
+		* @param The momenta p.
+		* @param The number of sites.
+		* @return The value of Σ p².
+		*/
+		double kinetic(const double* p, int n) noexcept;
+
+		/**
+		* Computes twice the action of the values.
+		*
+		* @param The values x including valid neighbours x[-1] and x[n].
+		* @param The diagonal coupling 2 + ω².
+		* @param The anharmonic coupling λ.
+		* @param The number of sites.
+		* @return The value of Σ (2 + ω²) x² + 2 λ x⁴ - x_i (x_{i-1} + x_{i+1}).
+		*/
+		double potential(const double* x, double osq, double lambda, int n) noexcept;
+
+		/**
+		* Computes the sum of the values.
+		*
+		* @param The values x.
+		* @param The number of sites.
+		* @return The value of Σ x.
+		*/
+		double sum(const double* x, int n) noexcept;
+
+		/**
+		* Computes the sum of the squared values.
+		*
+		* @param The values x.
+		* @param The number of sites.
+		* @return The value of Σ x².
+		*/
+		double sum_square(const double* x, int n) noexcept;
+	}
+}
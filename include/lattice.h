@@ -18,31 +18,71 @@
 */
 
 #pragma once
+#include "integrator.h"
+#include "acceleration.h"
+#include "checkpoint.h"
+#include "philox.h"
+#include "gaussian.h"
+#include "kernels.h"
+#include "team.h"
 #include <random>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstddef>
 
 namespace physics {
 	/**
-	* Lattice management class.
+	* Lattice management class. The sites are stored aligned with ghost cells
+	* around them, such that the kernels do not need periodic index checks.
+	* A large lattice may be decomposed into domains along its last dimension, which are
+	* owned by the members of a team of threads. The neighbouring domains read each other's
+	* boundary sites after a barrier and the partial sums are combined in a fixed tree order.
 	*/
 	class Lattice final {
 	public:
 		/**
 		* Constructs a new Lattice object.
 		*
-		* @param The reference to the random number generator to use.
-		* @param The number of temporal sites.
-		* @param The number of integration steps.
-		* @param The integration trajectory length.
+		* @param The random number generator, which seeds the generator of the momenta.
+		* @param The number of sites per dimension.
+		* @param The integrator for the equations of motion.
 		* @param The harmonic parameter, ω².
 		* @param The anharmonic parameter, λ.
+		* @param True if the momenta should use the Fourier accelerated kinetic mass, which requires a single dimension.
+		* @param The number of dimensions, at most 4, where the first one is contiguous in memory.
+		* @param The number of domains, i.e. threads, which is reduced for small lattices and the Fourier acceleration.
 		*/
-		Lattice(std::mt19937& rng, int nt, int nstep, double tau, double omegasq, double lambda) noexcept;
+		Lattice(std::mt19937& rng, int nt, const Integrator& integrator, double omegasq, double lambda, bool accelerated = false, int dimensions = 1, int domains = 1) noexcept;
 
 		/**
 		* Cleans everything up.
 		*/
 		~Lattice() noexcept;
 
+		/**
+		* Gets the number of sites of a lattice.
+		*
+		* @param The number of sites per dimension.
+		* @param The number of dimensions.
+		* @return The number of sites, nt^d.
+		*/
+		static int sites(int nt, int dimensions) noexcept;
+
+		/**
+		* Gets the number of domains the lattice is decomposed into.
+		*
+		* @return The number of domains, 1 if the lattice is not decomposed.
+		*/
+		int domains() const noexcept;
+
+		/**
+		* Gets the memory of the site arrays including their halos, where the velocities only count if they are not the momenta.
+		*
+		* @return The number of bytes.
+		*/
+		std::size_t footprint() const noexcept;
+
 		/**
 		* Gets the value at the specified site.
 		* 
@@ -76,32 +116,93 @@ namespace physics {
 		void p(int index, double value) noexcept;
 
 		/**
-		* Stores the current state of the lattice.
+		* Stores the current state of the lattice. The copy is made by the first
+		* sweep of the next integration, which writes into the backup buffer.
 		*/
 		void store() noexcept;
 
 		/**
-		* Restores the state of the lattice to the previously saved state.
+		* Restores the state of the lattice to the previously saved state by swapping the buffers.
 		*/
 		void restore() noexcept;
 
 		/**
-		* Randomizes the momenta.
+		* Randomizes the momenta, whose covariance is the kinetic mass.
 		*/
 		void randomize() noexcept;
 
+		/**
+		* Draws the momenta from a counter-based generator, such that the momentum of a site only
+		* depends on the key of the generator, the number of the trajectory and the site.
+		* 
+		* @param The generator, whose key is used.
+		*/
+		void generator(const numerics::Philox& philox) noexcept;
+
 		/**
 		* Integrates the sites' values by using their momenta.
 		*/
 		void integrate() noexcept;
 
 		/**
-		* Computes the value of the Hamilton operator.
+		* Gets the number of integration steps per trajectory.
 		* 
-		* @return The value of H, which is p²/2m + L.
+		* @return The number of steps.
+		*/
+		int steps() const noexcept;
+
+		/**
+		* Gets the size of a single integration step.
+		* 
+		* @return The step size ε.
+		*/
+		double step_size() const noexcept;
+
+		/**
+		* Changes the step size, where the number of steps is chosen such that the
+		* trajectory length is kept and the step size is not above the given one.
+		* 
+		* @param The maximum step size ε.
+		*/
+		void step_size(double eps) noexcept;
+
+		/**
+		* Stores the sites, the step size and the state of the generator of the momenta in a checkpoint.
+		* 
+		* @param The checkpoint to append to.
+		*/
+		void save(io::Checkpoint& checkpoint) const noexcept;
+
+		/**
+		* Restores the lattice from a checkpoint.
+		* 
+		* @param The checkpoint to read from.
+		*/
+		void load(io::Checkpoint& checkpoint);
+
+		/**
+		* Computes the value of the Hamilton operator. The energies are tracked by
+		* randomize and integrate, such that no additional sweep is required.
+		* 
+		* @return The value of H, which is p M⁻¹ p / 2 + L.
 		*/
 		double hamilton() const noexcept;
 
+		/**
+		* Computes the action of the sites of a lattice with the couplings of this lattice.
+		* 
+		* @param The lattice that provides the sites, which must have the same size.
+		* @return The value of L.
+		*/
+		double action(const Lattice& other) const noexcept;
+
+		/**
+		* Exchanges the sites with a lattice of the same size, while the couplings stay.
+		* 
+		* @param The lattice to exchange the sites with.
+		*/
+		void exchange(Lattice& other) noexcept;
+
 		/**
 		* Gets the average value of the sites.
 		* 
@@ -124,6 +225,18 @@ namespace physics {
 		double action_average() const noexcept;
 
 	protected:
+		/**
+		* Copies the boundary sites into the ghost cells of the periodic lattice.
+		*/
+		void refresh() const noexcept;
+
+		/**
+		* Copies the boundary sites of an array into its ghost cells, which are only used by a single dimension.
+		*
+		* @param The sites of the array.
+		*/
+		void refresh(double* sites) const noexcept;
+
 		/**
 		* Calculates the force at a specific site.
 		* 
@@ -133,29 +246,145 @@ namespace physics {
 		double force(int n) const noexcept;
 
 		/**
-		* Performs a single integration step over all sites.
+		* Gets twice the action of the current sites, which is cached.
 		* 
-		* @param The step size.
+		* @return The value of 2 L.
 		*/
-		void integrate_x(double eps) noexcept;
+		double potential_energy() const noexcept;
 
 		/**
-		* Performs a single integration step over all momenta.
+		* Performs an integration step over all sites followed by a step over all momenta in a single pass.
 		* 
-		* @param The step size.
+		* @param The target for the new sites, which may be the current sites.
+		* @param The step size of the sites.
+		* @param The step size of the momenta.
+		* @param The anharmonic coupling of the force, which is 0 for the harmonic part only.
+		* @return The value of Σ p² of the new momenta.
+		*/
+		double sweep(double* target, double ex, double ep, double coupling) noexcept;
+
+		/**
+		* Performs an integration step over all sites and computes the action in the same pass.
+		* 
+		* @param The step size of the sites.
+		* @return The value of 2 L of the new sites.
+		*/
+		double sweep_potential(double ex) noexcept;
+
+		/**
+		* Performs an integration step over all momenta.
+		* 
+		* @param The update of the momenta.
+		* @return The value of Σ p² of the new momenta.
+		*/
+		double kick(const Operation& op) noexcept;
+
+		/**
+		* Changes the target by a part of the force, y -= ε F(x).
+		* 
+		* @param The target y.
+		* @param The values x with valid ghost cells.
+		* @param The part of the force.
+		* @param The step size ε.
+		* @return The value of Σ y² of the new target.
+		*/
+		double apply(double* target, const double* x, Force force, double eps) const noexcept;
+
+		/**
+		* Integrates the sites' values by using their momenta, where every member of the team integrates its domain.
+		*/
+		void integrate_domains() noexcept;
+
+		/**
+		* Performs an integration step over the momenta of a domain.
+		*
+		* @param The update of the momenta.
+		* @param The current sites.
+		* @param The first slice of the domain.
+		* @param The end of the slices of the domain.
+		* @return The value of Σ p² of the new momenta of the domain.
+		*/
+		double kick(const Operation& op, const double* x, int first, int last) noexcept;
+
+		/**
+		* Changes the target of a domain by a part of the force, see apply.
+		*
+		* @param The target y.
+		* @param The values x with valid ghost cells.
+		* @param The part of the force.
+		* @param The step size ε.
+		* @param The first slice of the domain.
+		* @param The end of the slices of the domain.
+		* @return The value of Σ y² of the new target of the domain.
+		*/
+		double apply(double* target, const double* x, Force force, double eps, int first, int last) const noexcept;
+
+		/**
+		* Copies the boundary sites of an array into its ghost cells, where only the owners of the boundary sites write.
+		*
+		* @param The sites of the array.
+		* @param The first slice of the domain.
+		* @param The end of the slices of the domain.
+		*/
+		void refresh(double* sites, int first, int last) const noexcept;
+
+		/**
+		* Computes a sum over all domains.
+		*
+		* @param The part of the sum, which gets the rank of the domain.
+		* @return The partial sums combined in a fixed tree order.
+		*/
+		double reduce(const std::function<double(int)>& part) const noexcept;
+
+		/**
+		* Combines the partial sums of the domains pairwise.
+		*
+		* @param The first domain.
+		* @param The end of the domains.
+		* @param The index of the partial sum, i.e. 0 for the kinetic and 1 for the potential energy.
+		* @return The sum of the partial sums.
+		*/
+		double combine(int first, int last, int slot) const noexcept;
+
+		/**
+		* Gets the first site of a domain, which is even, such that the pairs of the Box-Muller transform are not split.
+		*
+		* @param The rank of the domain, where the number of domains gives the end of the last domain.
+		* @return The index of the site.
 		*/
-		void integrate_p(double eps) noexcept;
+		int site(int rank) const noexcept;
 
 	private:
-		std::mt19937& rng;
-		std::normal_distribution<double> gauss;
+		numerics::Gaussian normals;
+		numerics::Philox philox;
+		bool counter;
+		std::uint64_t trajectory;
 		int nt;
-		int nstep;
+		int dimensions;
+		int volume;
+		int domain_count;
+		int slice;
+		Integrator integrator;
 		double osq;
 		double lambda;
-		double eps;
+		kernels::Specialization kernel;
+		kernels::Specialization harmonic_kernel;
 		double* xv;
 		double* xbck;
+		double* xtmp;
 		double* pv;
+		double* vv;
+		std::unique_ptr<Acceleration> acceleration;
+		std::unique_ptr<concurrency::Team> team;
+		std::vector<int> bounds;
+		mutable std::vector<double> partials;
+		mutable double kinetic;
+		mutable double potential;
+		double backup;
+		mutable bool kinetic_valid;
+		mutable bool potential_valid;
+		mutable bool velocity_valid;
+		bool pending;
+		bool swapped;
 	};
 }
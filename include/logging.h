@@ -0,0 +1,213 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <iostream>
+#include <string>
+#include <chrono>
+
+/**
+* The most verbose level that is compiled in, i.e. 0 (none) to 4 (debug).
+*/
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 4
+#endif
+
+namespace diagnostics {
+	/**
+	* The severity of a log message.
+	*/
+	enum class Level : int {
+		none = 0,
+		error = 1,
+		warning = 2,
+		info = 3,
+		debug = 4
+	};
+
+	/**
+	* Leveled logger, which ignores messages above its level before formatting them.
+	*/
+	class Logger final {
+	public:
+		/**
+		* Constructs a new logger.
+		*
+		* @param The most verbose level to write.
+		* @param The stream for info and debug messages.
+		* @param The stream for errors and warnings.
+		*/
+		Logger(Level level, std::ostream& out = std::cout, std::ostream& err = std::cerr) noexcept :
+			level(level),
+			out(out),
+			err(err),
+			every(0),
+			seconds(0.0) {
+		}
+
+		/**
+		* Determines if messages of the given level are written.
+		*
+		* @param The level to check.
+		* @return True if the messages are written, otherwise false.
+		*/
+		bool enabled(Level level) const noexcept {
+			return static_cast<int>(level) <= LOG_LEVEL && level <= this->level;
+		}
+
+		/**
+		* Creates a logger for the same streams that writes at most the given level.
+		*
+		* @param The most verbose level to write.
+		* @return The restricted logger.
+		*/
+		Logger limit(Level level) const noexcept {
+			Logger logger { level < this->level ? level : this->level, out, err };
+			logger.progress(every, seconds);
+			return logger;
+		}
+
+		/**
+		* Sets how often the progress of long running processes is summarized.
+		*
+		* @param The number of updates between two summaries, 0 to disable.
+		* @param The number of seconds between two summaries, 0 to disable.
+		*/
+		void progress(int every, double seconds) noexcept {
+			this->every = every;
+			this->seconds = seconds;
+		}
+
+		/**
+		* Gets the number of updates between two progress summaries.
+		*
+		* @return The number of updates or 0.
+		*/
+		int progress_every() const noexcept {
+			return every;
+		}
+
+		/**
+		* Gets the number of seconds between two progress summaries.
+		*
+		* @return The number of seconds or 0.
+		*/
+		double progress_seconds() const noexcept {
+			return seconds;
+		}
+
+		template<typename... Args>
+		void error(const Args&... args) noexcept {
+			write(Level::error, args...);
+		}
+
+		template<typename... Args>
+		void warning(const Args&... args) noexcept {
+			write(Level::warning, args...);
+		}
+
+		template<typename... Args>
+		void info(const Args&... args) noexcept {
+			write(Level::info, args...);
+		}
+
+		template<typename... Args>
+		void debug(const Args&... args) noexcept {
+			write(Level::debug, args...);
+		}
+
+		/**
+		* Writes a single line, if the level is enabled.
+		*
+		* @param The level of the message.
+		* @param The parts of the message.
+		*/
+		template<typename... Args>
+		void write(Level level, const Args&... args) noexcept {
+			if (enabled(level)) {
+				auto& os = level <= Level::warning ? err : out;
+				print(os, args...);
+				os << '\n';
+			}
+		}
+
+	private:
+		static void print(std::ostream&) noexcept {
+		}
+
+		template<typename T, typename... Args>
+		static void print(std::ostream& os, const T& value, const Args&... args) noexcept {
+			os << value;
+			print(os, args...);
+		}
+
+		Level level;
+		std::ostream& out;
+		std::ostream& err;
+		int every;
+		double seconds;
+	};
+
+	/**
+	* Rate-limited summary of the updates of a long running process.
+	*/
+	class Progress final {
+	public:
+		/**
+		* Constructs a new progress summary.
+		*
+		* @param The logger to write the summaries to.
+		* @param The name of the process.
+		* @param The total number of updates.
+		*/
+		Progress(Logger& logger, const std::string& name, int total) noexcept;
+
+		/**
+		* Records an update and writes a summary if one is due.
+		*
+		* @param True if the update has been accepted.
+		* @param The average value of the sites.
+		* @param The average squared value of the sites.
+		*/
+		void update(bool accepted, double x, double xsquare) noexcept;
+
+		/**
+		* Writes the summary of the remaining updates.
+		*/
+		void finish() noexcept;
+
+	protected:
+		/**
+		* Writes the summary since the last one and resets the counters.
+		*/
+		void summarize() noexcept;
+
+	private:
+		Logger& logger;
+		std::string name;
+		int total;
+		int done;
+		int count;
+		int accepted;
+		double xs;
+		double xsqs;
+		bool active;
+		std::chrono::steady_clock::time_point last;
+	};
+}
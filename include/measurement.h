@@ -0,0 +1,49 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+
+namespace physics {
+	/**
+	* DTO structure with the observables of a single trajectory.
+	*/
+	struct Measurement {
+	public:
+		/**
+		* The index of the measurement.
+		*/
+		int n;
+		/**
+		* The average value of the sites.
+		*/
+		double x;
+		/**
+		* The average squared value of the sites.
+		*/
+		double x_square;
+		/**
+		* The average action per site.
+		*/
+		double action;
+		/**
+		* True if the trajectory has been accepted.
+		*/
+		bool accepted;
+	};
+}
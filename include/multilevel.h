@@ -0,0 +1,177 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <functional>
+#include <random>
+#include <vector>
+#include <complex>
+#include "configuration.h"
+#include "measurement.h"
+#include "lattice.h"
+#include "fourier.h"
+#include "autocorrelation.h"
+#include "threadpool.h"
+#include "logging.h"
+
+namespace physics {
+	/**
+	* Drives a two-level simulation, which measures the two-point correlator with a reduced variance.
+	* The lattice is split into slabs, whose first sites are the boundaries. Every trajectory of the
+	* whole lattice is followed by several updates of the interior sites of every slab with frozen
+	* boundaries. As the slabs are then independent, the correlator between different slabs is
+	* given by the product of the sub-averages of the sites.
+	*/
+	class Multilevel final {
+	public:
+		/**
+		* Constructs a new multilevel simulation.
+		*
+		* @param The configuration to use for the simulation.
+		* @param The number of sites per slab, which must divide the number of sites.
+		* @param The number of updates of the slabs per trajectory.
+		* @param The maximum distance of the correlator.
+		* @param The number of threads for updating the slabs, 0 uses the hardware concurrency.
+		* @param The logger to write information and errors to.
+		*/
+		Multilevel(const Configuration& configuration, int length, int updates, int distance, int threads, diagnostics::Logger& log) noexcept;
+
+		/**
+		* Runs the simulation.
+		*
+		* @param The callback to report the trajectories of the whole lattice to.
+		* @return True if the simulation has been completed, false if the thermalization failed.
+		*/
+		bool run(std::function<void(const Measurement&)> report) noexcept;
+
+		/**
+		* Gets the number of slabs.
+		*
+		* @return The number of slabs.
+		*/
+		int slabs() const noexcept;
+
+		/**
+		* Gets the acceptance rate of the trajectories of the whole lattice.
+		*
+		* @return The acceptance rate.
+		*/
+		double compute_acceptance() const noexcept;
+
+		/**
+		* Gets the acceptance rate of the updates of the single sites within the slabs.
+		*
+		* @return The acceptance rate.
+		*/
+		double compute_slab_acceptance() const noexcept;
+
+		/**
+		* Gets the average value of the sites.
+		*
+		* @return The average value of x.
+		*/
+		double compute_x() const noexcept;
+
+		/**
+		* Gets the average squared value of the sites.
+		*
+		* @return The average value of x².
+		*/
+		double compute_x_square() const noexcept;
+
+		/**
+		* Gets the two-point correlator, averaged over all translations.
+		*
+		* @return The values of <x_i x_{i+t}> and their errors for t = 0 to the maximum distance.
+		*/
+		std::vector<statistics::Observable<double>> compute_correlator() const noexcept;
+
+	protected:
+		/**
+		* Performs a single trajectory of the whole lattice.
+		*
+		* @return True if the trajectory has been accepted.
+		*/
+		bool step() noexcept;
+
+		/**
+		* Initializes the lattice.
+		*/
+		void init() noexcept;
+
+		/**
+		* Thermalizes the lattice with trajectories of the whole lattice.
+		*
+		* @return True if the acceptance rate is sufficient or the step size has been adapted, otherwise false.
+		*/
+		bool thermalize() noexcept;
+
+		/**
+		* Measures the correlator after every trajectory.
+		*
+		* @param The callback to report progress to.
+		*/
+		void measure(std::function<void(const Measurement&)> report) noexcept;
+
+		/**
+		* Updates the interior sites of a slab and gathers their sub-averages.
+		* The conditional Gaussian of the harmonic part is proposed for every site, which is
+		* accepted with the Metropolis probability of the anharmonic term.
+		*
+		* @param The index of the slab.
+		*/
+		void update(int slab) noexcept;
+
+		/**
+		* Assembles the correlator from the sub-averages of the slabs.
+		*/
+		void correlate() noexcept;
+
+	private:
+		int ntherm;
+		int nmeas;
+		int nt;
+		int length;
+		int updates;
+		int distance;
+		int lag;
+		double osq;
+		double lambda;
+		double target;
+		double delta;
+		diagnostics::Logger& log;
+		std::mt19937 rng;
+		std::uniform_real_distribution<double> dist;
+		Lattice lattice;
+		std::vector<std::mt19937> rngs;
+		concurrency::ThreadPool pool;
+		numerics::FourierTransform fft;
+		std::vector<double> sites;
+		std::vector<double> means;
+		std::vector<double> products;
+		std::vector<double> accepted;
+		std::vector<double> correlation;
+		std::vector<std::complex<double>> spectrum;
+		std::vector<double> csum;
+		std::vector<double> csqsum;
+		double acr;
+		double xsm;
+		double xsqm;
+	};
+}
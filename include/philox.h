@@ -0,0 +1,161 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace numerics {
+	/**
+	* The engine that draws the random numbers of a simulation.
+	*/
+	enum class Engine : int {
+		mt19937 = 0,
+		philox = 1
+	};
+
+	/**
+	* The counter-based Philox4x32-10 generator of Salmon et al. Every random number is a pure function
+	* of the key, i.e. the seed and the stream, and of a counter, which consists of the trajectory,
+	* the purpose and the index, such that any range of numbers can be computed independently.
+	* The generator also satisfies the requirements of a uniform random bit generator, which
+	* draws the counters of its sequence one after another.
+	*/
+	class Philox final {
+	public:
+		typedef std::uint32_t result_type;
+		typedef std::array<std::uint32_t, 4> block_type;
+
+		/**
+		* The purposes of the random numbers, which give disjoint counters.
+		*/
+		enum class Purpose : std::uint32_t {
+			momenta = 0,
+			metropolis = 1,
+			sequence = 2
+		};
+
+		/**
+		* Constructs a new generator.
+		*
+		* @param The seed, i.e. the first word of the key.
+		* @param The stream, e.g. the index of the chain, i.e. the second word of the key.
+		*/
+		explicit Philox(std::uint32_t seed = 0, std::uint32_t stream = 0) noexcept;
+
+		/**
+		* Fills an array with standard normal values, which are computed via the Box-Muller transform.
+		* The value of an index only depends on the key, the trajectory and the index.
+		*
+		* @param The target for the values.
+		* @param The number of values.
+		* @param The trajectory.
+		* @param The index of the first value, which must be even.
+		*/
+		void gaussians(double* target, int n, std::uint64_t trajectory, int offset = 0) const noexcept;
+
+		/**
+		* Computes a uniform value in (0, 1).
+		*
+		* @param The trajectory.
+		* @param The purpose of the value.
+		* @param The index of the value.
+		* @return The value that belongs to the counter.
+		*/
+		double uniform(std::uint64_t trajectory, Purpose purpose, std::uint32_t index = 0) const noexcept;
+
+		/**
+		* Draws the next value of the sequence.
+		*
+		* @return The next 32 random bits.
+		*/
+		result_type operator()() noexcept;
+
+		/**
+		* Restarts the sequence with a new seed, where the stream is kept.
+		*
+		* @param The new seed.
+		*/
+		void seed(std::uint32_t seed) noexcept;
+
+		/**
+		* Skips values of the sequence.
+		*
+		* @param The number of values to skip.
+		*/
+		void discard(std::uint64_t count) noexcept;
+
+		static constexpr result_type min() {
+			return 0;
+		}
+
+		static constexpr result_type max() {
+			return 0xffffffff;
+		}
+
+		/**
+		* Computes the 10 rounds of Philox4x32 for a counter.
+		*
+		* @param The counter.
+		* @param The first word of the key.
+		* @param The second word of the key.
+		* @return The 128 random bits of the counter.
+		*/
+		static block_type block(block_type counter, std::uint32_t k0, std::uint32_t k1) noexcept;
+
+		/**
+		* Gets the name of an engine.
+		*
+		* @param The engine.
+		* @return The name of the engine.
+		*/
+		static const char* name(Engine engine) noexcept;
+
+		/**
+		* Finds the engine with the given name.
+		*
+		* @param The name of the engine.
+		* @param The target for the engine.
+		* @return True if the engine has been found, otherwise false.
+		*/
+		static bool parse(const std::string& name, Engine& engine) noexcept;
+
+		friend bool operator ==(const Philox& a, const Philox& b) noexcept {
+			return a.key == b.key && a.position == b.position;
+		}
+
+		friend bool operator !=(const Philox& a, const Philox& b) noexcept {
+			return !(a == b);
+		}
+
+		friend std::ostream& operator <<(std::ostream& os, const Philox& philox) {
+			return os << philox.key[0] << ' ' << philox.key[1] << ' ' << philox.position;
+		}
+
+		friend std::istream& operator >>(std::istream& is, Philox& philox) {
+			return is >> philox.key[0] >> philox.key[1] >> philox.position;
+		}
+
+	private:
+		std::array<std::uint32_t, 2> key;
+		std::uint64_t position;
+	};
+}
@@ -0,0 +1,212 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstddef>
+
+/**
+* Enables the timers of the phases of a simulation, i.e. 0 (none) or 1.
+*/
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+namespace diagnostics {
+	/**
+	* The phases of a simulation that are timed.
+	*/
+	enum class Phase : int {
+		randomize = 0,
+		integrate = 1,
+		hamilton = 2,
+		metropolis = 3,
+		observables = 4,
+		report = 5,
+		analysis = 6
+	};
+
+	/**
+	* The number of phases.
+	*/
+	const int phases = 7;
+
+	/**
+	* A single entry of the timeline.
+	*/
+	struct TraceEvent {
+	public:
+		Phase phase;
+		int thread;
+		long long begin;
+		long long duration;
+	};
+
+	/**
+	* Aggregates the time spent in every phase over all threads and optionally records a timeline.
+	*/
+	class Profiler final {
+	public:
+		/**
+		* Gets the profiler of the process.
+		*
+		* @return The single instance.
+		*/
+		static Profiler& instance() noexcept;
+
+		/**
+		* Adds the duration of a phase.
+		*
+		* @param The phase.
+		* @param The start of the phase.
+		* @param The end of the phase.
+		*/
+		void record(Phase phase, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) noexcept;
+
+		/**
+		* Starts recording the timeline.
+		*
+		* @param The maximum number of events, further events are dropped.
+		*/
+		void trace(std::size_t capacity) noexcept;
+
+		/**
+		* Gets the time spent in a phase.
+		*
+		* @param The phase.
+		* @return The number of seconds.
+		*/
+		double seconds(Phase phase) const noexcept;
+
+		/**
+		* Gets the number of times a phase has been entered.
+		*
+		* @param The phase.
+		* @return The number of calls.
+		*/
+		long long calls(Phase phase) const noexcept;
+
+		/**
+		* Writes the time spent in every phase.
+		*
+		* @param The stream to write to.
+		*/
+		void summarize(std::ostream& os) const noexcept;
+
+		/**
+		* Writes the timeline as Chrome trace events, which can be opened with chrome://tracing.
+		*
+		* @param The name of the file.
+		* @return True if the file has been written.
+		*/
+		bool write_trace(const std::string& name) noexcept;
+
+		/**
+		* Gets the name of a phase.
+		*
+		* @param The phase.
+		* @return The name of the phase.
+		*/
+		static const char* name(Phase phase) noexcept;
+
+	protected:
+		/**
+		* Constructs the profiler, whose timeline starts now.
+		*/
+		Profiler() noexcept;
+
+		/**
+		* Gets the index of the calling thread in the timeline.
+		*
+		* @return The index of the thread.
+		*/
+		int thread() noexcept;
+
+	private:
+		std::chrono::steady_clock::time_point origin;
+		std::atomic<long long> durations[phases];
+		std::atomic<long long> counts[phases];
+		std::mutex mutex;
+		std::vector<TraceEvent> events;
+		std::vector<std::thread::id> threads;
+		std::atomic<std::size_t> capacity;
+		long long dropped;
+	};
+
+	/**
+	* Measures the time from its construction to its destruction.
+	*/
+	class ScopedTimer final {
+	public:
+		/**
+		* Starts the timer.
+		*
+		* @param The phase to attribute the time to.
+		*/
+		explicit ScopedTimer(Phase phase) noexcept :
+			phase(phase),
+			begin(std::chrono::steady_clock::now()) {
+		}
+
+		/**
+		* Stops the timer and adds the duration to the profiler.
+		*/
+		~ScopedTimer() noexcept {
+			Profiler::instance().record(phase, begin, std::chrono::steady_clock::now());
+		}
+
+	private:
+		Phase phase;
+		std::chrono::steady_clock::time_point begin;
+	};
+
+	/**
+	* Evaluates a function within a timer.
+	*
+	* @param The phase to attribute the time to.
+	* @param The function to evaluate.
+	* @return The result of the function.
+	*/
+	template<typename F>
+	auto profile(Phase phase, F f) -> decltype(f()) {
+		const ScopedTimer timer { phase };
+		return f();
+	}
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/**
+* PROFILE_SCOPE(phase) times the rest of the enclosing scope, PROFILE_CALL(phase, expression)
+* times a single expression and yields its value. Without PROFILE both vanish.
+*/
+#if PROFILE
+#define PROFILE_SCOPE(phase) const diagnostics::ScopedTimer PROFILE_CONCAT(scoped_timer_, __LINE__) { diagnostics::Phase::phase }
+#define PROFILE_CALL(phase, expression) diagnostics::profile(diagnostics::Phase::phase, [&]() { return expression; })
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_CALL(phase, expression) (expression)
+#endif
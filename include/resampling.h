@@ -0,0 +1,139 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "checkpoint.h"
+#include "threadpool.h"
+
+namespace statistics {
+	/**
+	* The resampling estimates of an observable.
+	*/
+	struct Estimate {
+	public:
+		/**
+		* The value of the observable for the means of all measurements.
+		*/
+		double mean;
+		/**
+		* The uncertainty from the jackknife.
+		*/
+		double jackknife;
+		/**
+		* The uncertainty from the bootstrap.
+		*/
+		double bootstrap;
+	};
+
+	/**
+	* Jackknife and bootstrap analysis of a series of measurements with several primary observables.
+	* The series is kept as a bounded number of bins, whose size doubles once they are full, such that the
+	* memory does not grow with the length of the series. The resampling works on coarser bins, whose size
+	* follows from the integrated autocorrelation time, and is spread over a thread pool.
+	*/
+	class Resampling final {
+	public:
+		/**
+		* Computes an observable from the means of the primary observables, e.g. a primary observable itself or a ratio.
+		* The estimator is called concurrently.
+		*/
+		typedef std::function<double(const double*)> Estimator;
+
+		/**
+		* The maximum number of primary observables.
+		*/
+		static const int max_observables = 16;
+
+		/**
+		* Constructs a new resampling analysis.
+		*
+		* @param The number of primary observables per measurement.
+		* @param The maximum number of bins that are kept, which is even.
+		*/
+		explicit Resampling(int observables, int capacity = 65536) noexcept;
+
+		/**
+		* Adds the next measurement of the series.
+		*
+		* @param The values of the primary observables.
+		*/
+		void add(const double* values) noexcept;
+
+		/**
+		* Gets the number of measurements that have been added.
+		*
+		* @return The number of measurements.
+		*/
+		std::size_t count() const noexcept;
+
+		/**
+		* Gets the size of the bins of the resampling, which span at least eight autocorrelation times
+		* while leaving enough bins for the estimates of the uncertainties.
+		*
+		* @param The integrated autocorrelation time τ_int, where 0.5 is an uncorrelated series.
+		* @return The number of measurements per bin, which is a multiple of the size of the kept bins.
+		*/
+		std::size_t bin_size(double tau) const noexcept;
+
+		/**
+		* Computes the jackknife and the bootstrap estimates of the given observables. Every replica of the
+		* bootstrap draws its bins from its own Philox stream, such that the result does not depend on the threads.
+		*
+		* @param The estimators of the observables.
+		* @param The integrated autocorrelation time τ_int.
+		* @param The number of bootstrap replicas.
+		* @param The seed of the bootstrap replicas.
+		* @param The thread pool that runs the resampling.
+		* @return The estimates of the observables in the given order.
+		*/
+		std::vector<Estimate> compute(const std::vector<Estimator>& estimators, double tau, int replicas, std::uint32_t seed, concurrency::ThreadPool& pool) const noexcept;
+
+		/**
+		* Stores the bins in a checkpoint.
+		* @param The checkpoint to append to.
+		*/
+		void save(io::Checkpoint& checkpoint) const noexcept;
+
+		/**
+		* Restores the bins from a checkpoint.
+		* @param The checkpoint to read from.
+		*/
+		void load(io::Checkpoint& checkpoint);
+
+	protected:
+		/**
+		* Merges neighbouring bins, which doubles the size of the bins.
+		*/
+		void coarsen() noexcept;
+
+	private:
+		int observables;
+		int capacity;
+		std::size_t n;
+		std::size_t width;
+		std::size_t filled;
+		std::size_t pending;
+		std::vector<double> bins;
+		std::vector<double> partial;
+	};
+}
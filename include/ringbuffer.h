@@ -0,0 +1,107 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace concurrency {
+	/**
+	* Bounded lock-free queue for exactly one producer and one consumer thread.
+	*/
+	template<typename T>
+	class RingBuffer final {
+	public:
+		/**
+		* Constructs a new ring buffer.
+		*
+		* @param The minimum capacity, which is rounded up to a power of 2.
+		*/
+		explicit RingBuffer(std::size_t capacity) :
+			items(round(capacity)),
+			mask(round(capacity) - 1),
+			head(0),
+			tail(0) {
+		}
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator =(const RingBuffer&) = delete;
+
+		/**
+		* Appends an item, must only be called by the producer.
+		*
+		* @param The item to append.
+		* @return True if the item was appended, false if the buffer is full.
+		*/
+		bool try_push(const T& item) noexcept {
+			const auto t = tail.load(std::memory_order_relaxed);
+
+			if (t - head.load(std::memory_order_acquire) == items.size())
+				return false;
+
+			items[t & mask] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		* Removes the oldest item, must only be called by the consumer.
+		*
+		* @param The target for the removed item.
+		* @return True if an item was removed, false if the buffer is empty.
+		*/
+		bool try_pop(T& item) noexcept {
+			const auto h = head.load(std::memory_order_relaxed);
+
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+
+			item = items[h & mask];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		* Gets the capacity of the buffer.
+		*
+		* @return The maximum number of items.
+		*/
+		std::size_t capacity() const noexcept {
+			return items.size();
+		}
+
+	private:
+		static std::size_t round(std::size_t capacity) noexcept {
+			std::size_t size = 1;
+
+			while (size < capacity)
+				size <<= 1;
+
+			return size;
+		}
+
+		std::vector<T> items;
+		const std::size_t mask;
+		char separator[64];
+		std::atomic<std::size_t> head;
+		char padding[64];
+		std::atomic<std::size_t> tail;
+	};
+}
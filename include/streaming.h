@@ -0,0 +1,118 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "autocorrelation.h"
+#include "checkpoint.h"
+
+namespace statistics {
+	/**
+	* Online estimator of the mean and the integrated autocorrelation time of a series.
+	* Only the most recent values of a bounded lag window and a hierarchy of bins are kept.
+	*/
+	class StreamingAutoCorrelation final {
+	public:
+		/**
+		* Constructs a new streaming autocorrelation estimator.
+		*
+		* @param The number of lags that are tracked at most.
+		* @param The value of the lambda parameter to control the offset.
+		*/
+		explicit StreamingAutoCorrelation(int window = 1000, int lambda = 100) noexcept;
+
+		/**
+		* Adds the next element of the series.
+		*
+		* @param The value to add.
+		*/
+		void add(double value) noexcept;
+
+		/**
+		* Gets the number of elements that have been added.
+		*
+		* @return The number of elements.
+		*/
+		std::size_t count() const noexcept;
+
+		/**
+		* Computes the mean of the series with its uncertainty from the binning analysis.
+		*
+		* @return A structure consisting of mean and uncertainty information.
+		*/
+		Observable<double> mean() const noexcept;
+
+		/**
+		* Computes the integrated autocorrelation time with its uncertainty.
+		*
+		* @return A structure consisting of mean and uncertainty information.
+		*/
+		Observable<double> compute() const noexcept;
+
+		/**
+		* Stores the running sums in a checkpoint.
+		* @param The checkpoint to append to.
+		*/
+		void save(io::Checkpoint& checkpoint) const noexcept;
+
+		/**
+		* Restores the running sums from a checkpoint.
+		* @param The checkpoint to read from.
+		*/
+		void load(io::Checkpoint& checkpoint);
+
+	protected:
+		/**
+		* Adds a value to the given level of the binning hierarchy.
+		*
+		* @param The level to add the value to.
+		* @param The (shifted) value of the bin.
+		*/
+		void bin(std::size_t level, double value) noexcept;
+
+		/**
+		* Computes the normalized autocorrelation values from the running sums.
+		*
+		* @param The number of lags to compute.
+		* @param The target where all autocorrelation values are stored.
+		* @return The variance of the series, which is 0 for a constant series.
+		*/
+		double auto_corr(int tmax, double* result) const noexcept;
+
+	private:
+		struct Bin {
+			double pending;
+			bool filled;
+			double sum;
+			double sum_square;
+			std::size_t count;
+		};
+
+		int window;
+		int lambda;
+		std::size_t n;
+		double shift;
+		double sum;
+		std::vector<double> head;
+		std::vector<double> recent;
+		std::vector<double> products;
+		std::vector<Bin> bins;
+	};
+}
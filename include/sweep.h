@@ -0,0 +1,112 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include "configuration.h"
+#include "measurement.h"
+#include "ensemble.h"
+#include "logging.h"
+
+namespace physics {
+	/**
+	* Runs a list of independent simulations with different configurations over a pool of threads.
+	*/
+	class Sweep final {
+	public:
+		/**
+		* Constructs a new parameter sweep.
+		*
+		* @param The configurations of the jobs.
+		* @param The number of threads to use, 0 uses the hardware concurrency.
+		* @param The maximum lag that is tracked for the autocorrelation analysis.
+		* @param The logger to write the completion of the jobs to.
+		*/
+		Sweep(const std::vector<Configuration>& configurations, int threads, int window, diagnostics::Logger& log) noexcept;
+
+		/**
+		* Runs all jobs, starting with the most expensive ones, and blocks until all are finished.
+		*
+		* @param The callback that is invoked before a job starts, which receives the index of the job.
+		* @param The callback to report progress to, which also receives the index of the job.
+		* @param The callback that is invoked after a job has finished.
+		* @return True if all jobs have been completed, false if the thermalization of a job failed.
+		*/
+		bool run(std::function<void(int)> start, std::function<void(int, const Measurement&)> report, std::function<void(int)> finish) noexcept;
+
+		/**
+		* Gets the configurations of the jobs.
+		*
+		* @return The configuration per job.
+		*/
+		const std::vector<Configuration>& configurations() const noexcept;
+
+		/**
+		* Gets the results of the jobs.
+		*
+		* @return The statistics per job.
+		*/
+		const std::vector<ChainResult>& results() const noexcept;
+
+		/**
+		* Gets the wall-clock times of the jobs.
+		*
+		* @return The seconds spent per job.
+		*/
+		const std::vector<double>& durations() const noexcept;
+
+		/**
+		* Estimates the relative cost of a job, which is proportional to the number of site updates.
+		*
+		* @param The configuration of the job.
+		* @return The estimated cost.
+		*/
+		static double cost(const Configuration& configuration) noexcept;
+
+		/**
+		* Expands a grid of parameters to the cartesian product of all values.
+		* The grid consists of assignments like "omegasq=0.5,1 lambda=0:1:0.25", where a value
+		* may be a range given by its first and last value and an optional increment.
+		*
+		* @param The specification of the grid.
+		* @param The configuration that provides all parameters that are not part of the grid.
+		* @param The target to append the configurations to.
+		* @return True if the grid could be parsed, otherwise false.
+		*/
+		static bool expand(const std::string& grid, const Configuration& base, std::vector<Configuration>& configurations) noexcept;
+
+	protected:
+		/**
+		* Orders the jobs by decreasing cost, such that the longest jobs are not started last.
+		*
+		* @return The indices of the jobs in the order of execution.
+		*/
+		std::vector<int> schedule() const noexcept;
+
+	private:
+		std::vector<Configuration> jobs;
+		int threads;
+		int window;
+		diagnostics::Logger& log;
+		std::vector<ChainResult> job_results;
+		std::vector<double> job_durations;
+	};
+}
@@ -0,0 +1,98 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+namespace concurrency {
+	/**
+	* A fixed team of threads, where every member keeps its rank, such that it always works on
+	* the same part of the data. The calling thread is the member with rank 0, while the other
+	* members wait for the next parallel region and may be pinned to a core each.
+	*/
+	class Team final {
+	public:
+		/**
+		* Constructs a new team.
+		*
+		* @param The number of members including the calling thread.
+		* @param True if every additional member should be pinned to its own core.
+		*/
+		explicit Team(int size, bool pinned = false) noexcept;
+
+		/**
+		* Stops and joins all members.
+		*/
+		~Team() noexcept;
+
+		/**
+		* Gets the number of members.
+		*
+		* @return The number of threads in the team including the calling thread.
+		*/
+		int size() const noexcept;
+
+		/**
+		* Runs the task on every member and blocks until all are finished.
+		*
+		* @param The task, which is called with the rank of the member.
+		*/
+		void run(std::function<void(int)> task) noexcept;
+
+		/**
+		* Waits within a parallel region until all members have arrived, i.e. the writes of
+		* every member before the barrier are visible to all members after it.
+		*/
+		void barrier() noexcept;
+
+	protected:
+		/**
+		* The loop executed by every additional member.
+		*
+		* @param The rank of the member.
+		*/
+		void work(int rank) noexcept;
+
+		/**
+		* Pins a member to the core with the same index among the allowed cores of the process.
+		*
+		* @param The thread of the member.
+		* @param The rank of the member.
+		*/
+		static void pin(std::thread& member, int rank) noexcept;
+
+	private:
+		std::vector<std::thread> members;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::function<void(int)> task;
+		std::uint64_t generation;
+		int finished;
+		bool stopping;
+		std::atomic<int> arrived;
+		std::atomic<std::uint64_t> phase;
+	};
+}
@@ -0,0 +1,160 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include "configuration.h"
+#include "measurement.h"
+#include "lattice.h"
+#include "adaptation.h"
+#include "threadpool.h"
+#include "logging.h"
+
+namespace physics {
+	/**
+	* Drives a replica exchange simulation, where every replica evolves one lattice with its own couplings
+	* and the sites of neighbouring replicas are swapped periodically with a Metropolis decision.
+	*/
+	class Tempering final {
+	public:
+		/**
+		* Constructs a new replica exchange simulation.
+		*
+		* @param The configurations of the replicas, which only differ in their couplings and seeds.
+		* @param The number of trajectories of every replica between two exchanges.
+		* @param The number of threads to use, 0 uses the hardware concurrency.
+		* @param The logger to write information and errors to.
+		*/
+		Tempering(const std::vector<Configuration>& configurations, int interval, int threads, diagnostics::Logger& log) noexcept;
+
+		/**
+		* Runs the simulation of all replicas.
+		*
+		* @param The callback to report progress to, which also receives the index of the replica.
+		* @return True if the simulation has been completed, false if the thermalization of a replica failed.
+		*/
+		bool run(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Gets the number of replicas.
+		*
+		* @return The number of replicas.
+		*/
+		int replicas() const noexcept;
+
+		/**
+		* Gets the acceptance rate of the trajectories of a replica.
+		*
+		* @param The index of the replica.
+		* @return The acceptance rate.
+		*/
+		double compute_acceptance(int replica) const noexcept;
+
+		/**
+		* Gets the average value of the sites of a replica.
+		*
+		* @param The index of the replica.
+		* @return The average value of x.
+		*/
+		double compute_x(int replica) const noexcept;
+
+		/**
+		* Gets the average squared value of the sites of a replica.
+		*
+		* @param The index of the replica.
+		* @return The average value of x².
+		*/
+		double compute_x_square(int replica) const noexcept;
+
+		/**
+		* Gets the acceptance rate of the exchanges between a replica and the next one.
+		*
+		* @param The index of the lower replica of the pair.
+		* @return The fraction of accepted exchanges.
+		*/
+		double compute_exchange(int replica) const noexcept;
+
+		/**
+		* Gets the number of integration steps of a replica.
+		*
+		* @param The index of the replica.
+		* @return The number of steps per trajectory.
+		*/
+		int steps(int replica) const noexcept;
+
+	protected:
+		/**
+		* Performs a single trajectory of a replica.
+		*
+		* @param The index of the replica.
+		* @return True if the trajectory has been accepted.
+		*/
+		bool step(int replica) noexcept;
+
+		/**
+		* Initializes all replicas.
+		*/
+		void init() noexcept;
+
+		/**
+		* Thermalizes all replicas including exchanges.
+		*
+		* @return True if the acceptance rates of all replicas are sufficient or their step sizes have been adapted, otherwise false.
+		*/
+		bool thermalize() noexcept;
+
+		/**
+		* Measures all replicas, which are exchanged after every interval.
+		*
+		* @param The callback to report progress to.
+		*/
+		void measure(std::function<void(int, const Measurement&)> report) noexcept;
+
+		/**
+		* Proposes exchanges between neighbouring replicas, where the even and odd pairs alternate.
+		*
+		* @param True if the exchanges should be counted.
+		*/
+		void exchange(bool counting) noexcept;
+
+	private:
+		int ntherm;
+		int nmeas;
+		int interval;
+		int rounds;
+		double target;
+		diagnostics::Logger& log;
+		std::vector<std::mt19937> rngs;
+		std::vector<std::uniform_real_distribution<double>> dists;
+		std::vector<std::unique_ptr<Lattice>> lattices;
+		std::vector<DualAveraging> adaptations;
+		std::vector<double> deltas;
+		std::mt19937 rng;
+		std::uniform_real_distribution<double> dist;
+		concurrency::ThreadPool pool;
+		std::vector<double> xsm;
+		std::vector<double> xsqm;
+		std::vector<double> acr;
+		std::vector<double> attempts;
+		std::vector<double> swaps;
+	};
+}
@@ -0,0 +1,84 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace concurrency {
+	/**
+	* A fixed set of worker threads that processes indexed batches of tasks.
+	*/
+	class ThreadPool final {
+	public:
+		/**
+		* Constructs a new thread pool.
+		*
+		* @param The number of worker threads, 0 uses the hardware concurrency.
+		*/
+		explicit ThreadPool(int threads) noexcept;
+
+		/**
+		* Stops and joins all worker threads.
+		*/
+		~ThreadPool() noexcept;
+
+		/**
+		* Gets the number of worker threads.
+		*
+		* @return The number of threads in the pool.
+		*/
+		int size() const noexcept;
+
+		/**
+		* Runs the task for every index and blocks until all are finished.
+		*
+		* @param The number of indices, i.e. the task is called with 0 to count - 1.
+		* @param The task to execute for each index.
+		*/
+		void run(int count, std::function<void(int)> task) noexcept;
+
+		/**
+		* Gets the number of threads that should be used by default.
+		*
+		* @return The number of hardware threads, at least 1.
+		*/
+		static int hardware_threads() noexcept;
+
+	protected:
+		/**
+		* The loop executed by every worker thread.
+		*/
+		void work() noexcept;
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::function<void(int)> task;
+		int count;
+		int next;
+		int pending;
+		bool stopping;
+	};
+}
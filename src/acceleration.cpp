@@ -0,0 +1,107 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "acceleration.h"
+#include <cmath>
+
+/**
+* Gets the length of the transform for a cyclic convolution over the given number of sites.
+*
+* @param The number of sites.
+* @return The number of sites if it is a power of 2, otherwise the padded length.
+*/
+inline std::size_t padded_length(int nt) noexcept {
+	const auto n = static_cast<std::size_t>(nt);
+	return numerics::FourierTransform::next_power_of_two(n) == n ? n : numerics::FourierTransform::next_power_of_two(2 * n);
+}
+
+physics::Acceleration::Acceleration(int nt, double omegasq) noexcept :
+	nt(nt),
+	offset(padded_length(nt) == static_cast<std::size_t>(nt) ? 0 : nt),
+	fft(padded_length(nt)),
+	root(),
+	inverse(),
+	values(fft.size()),
+	spectrum(fft.size() / 2 + 1) {
+	const auto pi = std::acos(-1.0);
+	const auto norm = 1.0 / (4.0 + omegasq);
+	std::vector<std::complex<double>> roots(nt / 2 + 1);
+	std::vector<std::complex<double>> inverses(nt / 2 + 1);
+
+	for (int k = 0; k <= nt / 2; ++k) {
+		const auto s = std::sin(pi * static_cast<double>(k) / static_cast<double>(nt));
+		const auto mass = (4.0 * s * s + omegasq) * norm;
+		roots[k] = std::sqrt(mass);
+		inverses[k] = 1.0 / mass;
+	}
+
+	root = pad(roots);
+	inverse = pad(inverses);
+}
+
+std::vector<std::complex<double>> physics::Acceleration::pad(const std::vector<std::complex<double>>& factors) noexcept {
+	if (offset == 0)
+		return factors;
+
+	// The kernel of the cyclic convolution is the inverse transform of the factors over the lattice.
+	numerics::FourierTransform lattice { static_cast<std::size_t>(nt) };
+	std::vector<double> kernel(fft.size(), 0.0);
+	std::vector<std::complex<double>> result(fft.size() / 2 + 1);
+	lattice.inverse(factors.data(), kernel.data());
+	fft.forward(kernel.data(), result.data());
+	return result;
+}
+
+void physics::Acceleration::filter(const double* input, double* output, int stride, const std::vector<std::complex<double>>& factors) noexcept {
+	const auto length = static_cast<int>(values.size());
+
+	// The values are extended periodically, such that the outputs from the offset on are not affected by the padding.
+	for (int i = 0; i < nt; ++i)
+		values[i] = input[i * stride];
+
+	for (int i = nt; i < length; ++i)
+		values[i] = i < 2 * nt ? values[i - nt] : 0.0;
+
+	fft.forward(values.data(), spectrum.data());
+
+	for (std::size_t k = 0; k < spectrum.size(); ++k) {
+		const auto a = spectrum[k];
+		const auto b = factors[k];
+		spectrum[k] = std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+	}
+
+	fft.inverse(spectrum.data(), values.data());
+
+	for (int i = 0; i < nt; ++i)
+		output[i * stride] = values[offset + i];
+}
+
+void physics::Acceleration::momenta(const double* noise, double* p, int stride) noexcept {
+	filter(noise, p, stride, root);
+}
+
+double physics::Acceleration::velocities(const double* p, double* v, int stride) noexcept {
+	auto sum = 0.0;
+	filter(p, v, stride, inverse);
+
+	for (int i = 0; i < nt; ++i)
+		sum += p[i * stride] * v[i * stride];
+
+	return sum;
+}
@@ -0,0 +1,71 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "adaptation.h"
+#include <cmath>
+
+/**
+* The shrinkage of the step size towards μ.
+*/
+const double gamma_shrinkage = 0.05;
+
+/**
+* The offset of the iteration count, which stabilizes the first iterations.
+*/
+const double iteration_offset = 10.0;
+
+/**
+* The exponent of the weights of the averaged step size.
+*/
+const double average_decay = 0.75;
+
+physics::DualAveraging::DualAveraging(double target, double eps) noexcept :
+	target(target),
+	mu(std::log(10.0 * eps)),
+	statistic(0.0),
+	log_eps(std::log(eps)),
+	log_average(0.0),
+	m(0) {
+}
+
+double physics::DualAveraging::update(double acceptance) noexcept {
+	using std::sqrt;
+	using std::pow;
+	++m;
+
+	const auto count = static_cast<double>(m);
+	const auto weight = 1.0 / (count + iteration_offset);
+	const auto eta = pow(count, -average_decay);
+	statistic = (1.0 - weight) * statistic + weight * (target - acceptance);
+	log_eps = mu - sqrt(count) / gamma_shrinkage * statistic;
+	log_average = eta * log_eps + (1.0 - eta) * log_average;
+	return step_size();
+}
+
+double physics::DualAveraging::step_size() const noexcept {
+	return std::exp(log_eps);
+}
+
+double physics::DualAveraging::average() const noexcept {
+	return m > 0 ? std::exp(log_average) : step_size();
+}
+
+int physics::DualAveraging::iterations() const noexcept {
+	return m;
+}
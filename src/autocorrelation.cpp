@@ -18,11 +18,18 @@
 */
 
 #include "autocorrelation.h"
+#include "fourier.h"
 #include <cmath>
 #include <limits>
+#include <complex>
 
 using std::size_t;
 
+/**
+* The minimum number of lags before the FFT is considered for the autocorrelation.
+*/
+const int fft_threshold = 64;
+
 int abs(int number) noexcept {
 	return number >= 0 ? number : -number;
 }
@@ -48,10 +55,8 @@ statistics::Observable<double> statistics::AutoCorrelation::compute() const noex
 
 	const auto n = elements.size();
 	const auto tmax = (n - lambda) / 2;
-	double g[n];
-	double eg[tmax];
-	const auto g0 = auto_corr(n - 1, g);
-	sigma_corr(tmax, g, eg);
+	std::vector<double> g(n);
+	const auto g0 = auto_corr(n - 1, g.data());
 
 	auto sigma = 0.0;
 	auto tau = 0.5;
@@ -61,7 +66,7 @@ statistics::Observable<double> statistics::AutoCorrelation::compute() const noex
 		for (size_t t = 1; t < w; ++t) {
 			tau += g[t];
 
-			if (g[t] <= eg[t]) {
+			if (g[t] <= sigma_corr(t, g.data())) {
 				w = t;
 				break;
 			}
@@ -103,6 +108,11 @@ double statistics::AutoCorrelation::auto_corr(int tmax, double* g) const noexcep
 		g0 = g0 * g0 * static_cast<double>(n - 1);  
 		g[0] = 1.0;
 
+		if (use_fft(tmax)) {
+			auto_corr_fft(tmax, g0, g);
+			return g0;
+		}
+
 		for (int t = 1; t < tmax; ++t) {
 			auto var = 0.0;
 
@@ -116,24 +126,53 @@ double statistics::AutoCorrelation::auto_corr(int tmax, double* g) const noexcep
 	return g0;
 }
 
-void statistics::AutoCorrelation::sigma_corr(int tmax, double *g, double *eg) const noexcept {
+bool statistics::AutoCorrelation::use_fft(int tmax) const noexcept {
+	using std::log2;
+
+	if (tmax < fft_threshold)
+		return false;
+
+	const auto n = static_cast<double>(elements.size());
+	const auto size = static_cast<double>(numerics::FourierTransform::next_power_of_two(2 * elements.size()));
+	const auto direct = static_cast<double>(tmax) * (n - 0.5 * static_cast<double>(tmax));
+	return direct > 4.0 * size * log2(size);
+}
+
+void statistics::AutoCorrelation::auto_corr_fft(int tmax, double g0, double* g) const noexcept {
+	using std::norm;
+
+	const auto n = elements.size();
+	numerics::FourierTransform fft { numerics::FourierTransform::next_power_of_two(2 * n) };
+	const auto size = fft.size();
+	std::vector<double> data(size, 0.0);
+	std::vector<std::complex<double>> spectrum(size / 2 + 1);
+
+	for (size_t k = 0; k < n; ++k)
+		data[k] = elements[k] - avg;
+
+	fft.forward(data.data(), spectrum.data());
+
+	for (auto& coefficient : spectrum)
+		coefficient = norm(coefficient);
+
+	fft.inverse(spectrum.data(), data.data());
+
+	for (int t = 1; t < tmax; ++t)
+		g[t] = data[t] / (g0 * static_cast<double>(n - t));
+}
+
+double statistics::AutoCorrelation::sigma_corr(int t, const double* g) const noexcept {
 	using std::sqrt;
 	using std::pow;
 
 	const auto n = static_cast<double>(elements.size());
-	eg[0] = 0.0;
+	auto sm = 0.0;
 
-	if (g[0] == 0.0) {
-		for (int t = 1; t < tmax; ++t)
-			eg[t] = 0.0;
-	} else {
-		for (int t = 1; t < tmax; ++t) {
-			auto sm = 0.0;
+	if (g[0] == 0.0)
+		return 0.0;
 
-			for (int k = 1; k <= (t + lambda); ++k)
-				sm += pow(g[k + t] + g[abs(k - t)] - 2.0 * g[t] * g[k], 2);
+	for (int k = 1; k <= (t + lambda); ++k)
+		sm += pow(g[k + t] + g[abs(k - t)] - 2.0 * g[t] * g[k], 2);
 
-			eg[t] = sqrt(sm / n);
-		}
-	}
+	return sqrt(sm / n);
 }
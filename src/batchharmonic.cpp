@@ -0,0 +1,163 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "batchharmonic.h"
+#include "adaptation.h"
+#include <cmath>
+
+physics::BatchHarmonic::BatchHarmonic(const physics::Configuration& cfg, const std::vector<int>& seeds, diagnostics::Logger& log) noexcept :
+	ntherm(cfg.ntherm),
+	nmeas(cfg.nmeas),
+	target(cfg.target),
+	log(log),
+	rngs(seeds.begin(), seeds.end()),
+	dists(seeds.size(), std::uniform_real_distribution<double>(0.0, 1.0)),
+	lattice(rngs, cfg.nt, Integrator { cfg.integrator, cfg.nstep, cfg.tau, cfg.omelyan, cfg.substeps }, cfg.omega_square, cfg.lambda, cfg.fourier),
+	before(seeds.size()),
+	after(seeds.size()),
+	accepted(seeds.size()),
+	xs(seeds.size()),
+	xsqs(seeds.size()),
+	actions(seeds.size()),
+	xsm(seeds.size(), 0.0),
+	xsqm(seeds.size(), 0.0),
+	acr(seeds.size(), 0.0) {
+}
+
+int physics::BatchHarmonic::replicas() const noexcept {
+	return lattice.replicas();
+}
+
+bool physics::BatchHarmonic::run(std::function<void(int, const physics::Measurement&)> report) noexcept {
+	init();
+
+	if (!thermalize())
+		return false;
+
+	measure(report);
+	return true;
+}
+
+void physics::BatchHarmonic::init() noexcept {
+	// The initial trajectories are not checked, hence they could diverge for a step size that still needs to be adapted.
+	if (target > 0.0)
+		return;
+
+	for (int n = 0; n < 10; ++n) {
+		lattice.randomize();
+		lattice.integrate();
+	}
+}
+
+bool physics::BatchHarmonic::thermalize() noexcept {
+	const auto k = replicas();
+	std::vector<double> arate(k, 0.0);
+	DualAveraging adaptation { target, lattice.step_size() };
+	const auto adapting = target > 0.0;
+	log.info("Running thermalization of ", k, " replicas ...");
+
+	for (int n = 0; n < ntherm; ++n) {
+		auto probability = 0.0;
+		step();
+
+		for (int r = 0; r < k; ++r) {
+			const auto delta = after[r] - before[r];
+			probability += delta > 0.0 ? exp(-delta) : (delta <= 0.0 ? 1.0 : 0.0);
+			arate[r] += accepted[r];
+		}
+
+		if (adapting)
+			lattice.step_size(adaptation.update(probability / static_cast<double>(k)));
+	}
+
+	log.info("Thermalization finished!");
+
+	if (adapting) {
+		lattice.step_size(adaptation.average());
+		log.info("Adapted the step size to ε = ", lattice.step_size(), " with ", lattice.steps(), " steps for an acceptance of ", target, ".");
+		return true;
+	}
+
+	auto sufficient = true;
+
+	for (int r = 0; r < k; ++r) {
+		if (4.0 * arate[r] < ntherm) {
+			log.error("Bad acceptance rate in thermalisation of replica ", r, "!");
+			sufficient = false;
+		}
+	}
+
+	return sufficient;
+}
+
+void physics::BatchHarmonic::measure(std::function<void(int, const physics::Measurement&)> report) noexcept {
+	const auto k = replicas();
+	log.info("Starting measurements of ", k, " replicas ...");
+
+	for (int n = 0; n < nmeas; ++n) {
+		step();
+		lattice.observables(xs.data(), xsqs.data(), actions.data());
+
+		for (int r = 0; r < k; ++r) {
+			report(r, physics::Measurement { n, xs[r], xsqs[r], actions[r], accepted[r] });
+			acr[r] += accepted[r];
+			xsm[r] += xs[r];
+			xsqm[r] += xsqs[r];
+		}
+	}
+
+	log.info("Measurements finished!");
+}
+
+void physics::BatchHarmonic::step() noexcept {
+	const auto k = replicas();
+	lattice.randomize();
+	lattice.store();
+	lattice.hamilton(before.data());
+	lattice.integrate();
+	lattice.hamilton(after.data());
+
+	for (int r = 0; r < k; ++r) {
+		const auto delta = after[r] - before[r];
+		accepted[r] = delta <= 0.0 || dists[r](rngs[r]) <= exp(-delta);
+
+		if (!accepted[r])
+			lattice.restore(r);
+	}
+}
+
+double physics::BatchHarmonic::compute_acceptance(int r) const noexcept {
+	return acr[r] / static_cast<double>(nmeas);
+}
+
+double physics::BatchHarmonic::compute_x(int r) const noexcept {
+	return xsm[r] / static_cast<double>(nmeas);
+}
+
+double physics::BatchHarmonic::compute_x_square(int r) const noexcept {
+	return xsqm[r] / static_cast<double>(nmeas);
+}
+
+int physics::BatchHarmonic::steps() const noexcept {
+	return lattice.steps();
+}
+
+double physics::BatchHarmonic::step_size() const noexcept {
+	return lattice.step_size();
+}
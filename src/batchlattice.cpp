@@ -0,0 +1,222 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "batchlattice.h"
+#include "kernels.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+physics::BatchLattice::BatchLattice(std::vector<std::mt19937>& rngs, int nt, const Integrator& integrator, double omegasq, double lambda, bool accelerated) noexcept :
+	rngs(rngs),
+	gauss(rngs.size()),
+	k(static_cast<int>(rngs.size())),
+	nt(nt),
+	integrator(integrator),
+	osq(2.0 + omegasq),
+	lambda(lambda),
+	xv(kernels::allocate((nt + 2) * k) + k),
+	xbck(kernels::allocate((nt + 2) * k) + k),
+	xtmp(kernels::allocate((nt + 2) * k) + k),
+	pv(kernels::allocate(nt * k)),
+	vv(accelerated ? kernels::allocate(nt * k) : pv),
+	acceleration(accelerated ? new Acceleration(nt, omegasq) : nullptr) {
+	const auto factor = omegasq > 0.0 ? 1.0 / sqrt(2.0 * omegasq) : 1.0;
+
+	for (int r = 0; r < k; ++r) {
+		for (int i = 0; i < nt; ++i)
+			xv[i * k + r] = gauss[r](rngs[r]) * factor;
+	}
+}
+
+physics::BatchLattice::~BatchLattice() noexcept {
+	kernels::release(xv - k);
+	kernels::release(xbck - k);
+	kernels::release(xtmp - k);
+	kernels::release(pv);
+
+	if (vv != pv)
+		kernels::release(vv);
+}
+
+int physics::BatchLattice::replicas() const noexcept {
+	return k;
+}
+
+void physics::BatchLattice::store() noexcept {
+	std::memcpy(xbck, xv, sizeof(double) * nt * k);
+}
+
+void physics::BatchLattice::restore(int r) noexcept {
+	for (int i = 0; i < nt; ++i)
+		xv[i * k + r] = xbck[i * k + r];
+}
+
+void physics::BatchLattice::randomize() noexcept {
+	for (int r = 0; r < k; ++r) {
+		auto& g = gauss[r];
+		auto& rng = rngs[r];
+
+		for (int i = 0; i < nt; ++i)
+			pv[i * k + r] = g(rng);
+
+		if (acceleration)
+			acceleration->momenta(pv + r, pv + r, k);
+	}
+}
+
+void physics::BatchLattice::refresh() const noexcept {
+	std::memcpy(xv - k, xv + (nt - 1) * k, sizeof(double) * k);
+	std::memcpy(xv + nt * k, xv, sizeof(double) * k);
+}
+
+void physics::BatchLattice::integrate_x(double eps) noexcept {
+	if (acceleration) {
+		for (int r = 0; r < k; ++r)
+			acceleration->velocities(pv + r, vv + r, k);
+	}
+
+	kernels::drift(xv, xv, vv, eps, nt * k);
+}
+
+void physics::BatchLattice::apply(double* y, const double* x, Force force, double eps) const noexcept {
+	switch (force) {
+		case Force::harmonic:
+			kernels::kick(y, x, osq, 0.0, eps, nt * k, k);
+			break;
+		case Force::anharmonic:
+			kernels::kick_anharmonic(y, x, lambda, eps, nt * k);
+			break;
+		default:
+			kernels::kick(y, x, osq, lambda, eps, nt * k, k);
+			break;
+	}
+}
+
+void physics::BatchLattice::integrate_p(double eps, double gradient, Force force) noexcept {
+	refresh();
+
+	if (gradient == 0.0) {
+		apply(pv, xv, force, eps);
+		return;
+	}
+
+	if (acceleration) {
+		// The shift follows the velocities of the force, x - g M⁻¹ F, so the velocities serve as scratch.
+		std::fill(vv, vv + nt * k, 0.0);
+		apply(vv, xv, force, gradient);
+
+		for (int r = 0; r < k; ++r)
+			acceleration->velocities(vv + r, vv + r, k);
+
+		kernels::drift(xtmp, xv, vv, 1.0, nt * k);
+	} else {
+		std::memcpy(xtmp, xv, sizeof(double) * nt * k);
+		apply(xtmp, xv, force, gradient);
+	}
+
+	std::memcpy(xtmp - k, xtmp + (nt - 1) * k, sizeof(double) * k);
+	std::memcpy(xtmp + nt * k, xtmp, sizeof(double) * k);
+	apply(pv, xtmp, force, eps);
+}
+
+void physics::BatchLattice::integrate() noexcept {
+	for (const auto& op : integrator.operations()) {
+		if (op.drift)
+			integrate_x(op.coefficient);
+		else
+			integrate_p(op.coefficient, op.gradient, op.force);
+	}
+}
+
+int physics::BatchLattice::steps() const noexcept {
+	return integrator.steps();
+}
+
+double physics::BatchLattice::step_size() const noexcept {
+	return integrator.step_size();
+}
+
+void physics::BatchLattice::step_size(double eps) noexcept {
+	const auto steps = std::ceil(integrator.trajectory_length() / eps);
+	integrator = integrator.resize(steps < 1.0 ? 1 : (steps > Integrator::max_steps ? Integrator::max_steps : static_cast<int>(steps)));
+}
+
+void physics::BatchLattice::potential(double* result) const noexcept {
+	const auto l = 2.0 * lambda;
+	refresh();
+
+	for (int r = 0; r < k; ++r)
+		result[r] = 0.0;
+
+	for (int i = 0; i < nt; ++i) {
+		const auto row = xv + i * k;
+
+		for (int r = 0; r < k; ++r) {
+			const auto x = row[r];
+			result[r] += x * (x * (osq + l * x * x) - (row[r - k] + row[r + k]));
+		}
+	}
+}
+
+void physics::BatchLattice::hamilton(double* result) const noexcept {
+	potential(result);
+
+	if (acceleration) {
+		for (int r = 0; r < k; ++r)
+			result[r] = 0.5 * (acceleration->velocities(pv + r, vv + r, k) + result[r]);
+
+		return;
+	}
+
+	for (int i = 0; i < nt; ++i) {
+		const auto row = pv + i * k;
+
+		for (int r = 0; r < k; ++r)
+			result[r] += row[r] * row[r];
+	}
+
+	for (int r = 0; r < k; ++r)
+		result[r] *= 0.5;
+}
+
+void physics::BatchLattice::observables(double* x, double* xsquare, double* action) const noexcept {
+	const auto factor = 1.0 / static_cast<double>(nt);
+	potential(action);
+
+	for (int r = 0; r < k; ++r) {
+		x[r] = 0.0;
+		xsquare[r] = 0.0;
+	}
+
+	for (int i = 0; i < nt; ++i) {
+		const auto row = xv + i * k;
+
+		for (int r = 0; r < k; ++r) {
+			x[r] += row[r];
+			xsquare[r] += row[r] * row[r];
+		}
+	}
+
+	for (int r = 0; r < k; ++r) {
+		x[r] *= factor;
+		xsquare[r] *= factor;
+		action[r] *= 0.5 * factor;
+	}
+}
@@ -0,0 +1,119 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "checkpoint.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const char checkpoint_magic[8] = { 'H', 'A', 'R', 'M', 'C', 'K', 'P', '\0' };
+
+io::Checkpoint::Checkpoint() noexcept :
+	data(),
+	offset(0) {
+	append(checkpoint_magic, sizeof(checkpoint_magic));
+	put(checkpoint_version);
+}
+
+io::Checkpoint io::Checkpoint::load(const std::string& name) {
+	std::ifstream input { name, std::ios::binary };
+
+	if (!input)
+		throw std::runtime_error("The checkpoint " + name + " cannot be opened.");
+
+	Checkpoint checkpoint;
+	checkpoint.data.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	char magic[sizeof(checkpoint_magic)];
+	checkpoint.extract(magic, sizeof(magic));
+
+	if (std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 || checkpoint.get<std::uint32_t>() != checkpoint_version)
+		throw std::runtime_error("The file " + name + " is not a compatible checkpoint.");
+
+	return checkpoint;
+}
+
+bool io::Checkpoint::save(const std::string& name) const noexcept {
+	const auto temporary = name + ".tmp";
+	auto file = std::fopen(temporary.c_str(), "wb");
+
+	if (file == nullptr)
+		return false;
+
+	auto success = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+
+#ifdef _WIN32
+	success = success && ::_commit(::_fileno(file)) == 0;
+#else
+	success = success && ::fsync(::fileno(file)) == 0;
+#endif
+
+	success = std::fclose(file) == 0 && success;
+
+#ifdef _WIN32
+	std::remove(name.c_str());
+#endif
+
+	if (!success || std::rename(temporary.c_str(), name.c_str()) != 0) {
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void io::Checkpoint::put(const double* values, std::size_t count) noexcept {
+	put(static_cast<std::uint64_t>(count));
+	append(values, count * sizeof(double));
+}
+
+void io::Checkpoint::get(double* values, std::size_t count) {
+	if (get<std::uint64_t>() != count)
+		throw std::runtime_error("The checkpoint does not match the configuration.");
+
+	extract(values, count * sizeof(double));
+}
+
+void io::Checkpoint::get(std::vector<double>& values) {
+	const auto count = get<std::uint64_t>();
+
+	if (count > (data.size() - offset) / sizeof(double))
+		throw std::runtime_error("The checkpoint is truncated.");
+
+	values.resize(static_cast<std::size_t>(count));
+	extract(values.data(), values.size() * sizeof(double));
+}
+
+void io::Checkpoint::append(const void* bytes, std::size_t count) noexcept {
+	const auto start = reinterpret_cast<const char*>(bytes);
+	data.insert(data.end(), start, start + count);
+}
+
+void io::Checkpoint::extract(void* bytes, std::size_t count) {
+	if (count > data.size() - offset)
+		throw std::runtime_error("The checkpoint is truncated.");
+
+	std::memcpy(bytes, data.data() + offset, count);
+	offset += count;
+}
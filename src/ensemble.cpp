@@ -0,0 +1,180 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "ensemble.h"
+#include "harmonic.h"
+#include "batchharmonic.h"
+#include "threadpool.h"
+#include "streaming.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+
+physics::Ensemble::Ensemble(const physics::Configuration& cfg, int chains, int threads, int batch, int window, diagnostics::Logger& log) noexcept :
+	configuration(cfg),
+	chains(chains),
+	threads(threads > 0 ? threads : concurrency::ThreadPool::hardware_threads()),
+	batch(batch > 1 ? std::min(batch, chains) : 1),
+	window(window),
+	log(log),
+	chain_results(chains) {
+}
+
+int physics::Ensemble::seed(int chain) const noexcept {
+	std::seed_seq sequence { configuration.seed, chain };
+	std::uint32_t value = 0;
+	sequence.generate(&value, &value + 1);
+	return static_cast<int>(value & 0x7fffffff);
+}
+
+bool physics::Ensemble::run(std::function<void(int, const Measurement&)> report) noexcept {
+	if (batch > 1)
+		run_batches(report);
+	else
+		run_chains(report);
+
+	return std::none_of(chain_results.begin(), chain_results.end(), [](const ChainResult& r) {
+		return r.failed;
+	});
+}
+
+physics::ChainResult physics::Ensemble::failure(int steps) noexcept {
+	const auto nan = std::nan("");
+	return ChainResult { nan, nan, nan, statistics::Observable<double> { nan, nan }, steps, true };
+}
+
+void physics::Ensemble::run_chains(std::function<void(int, const Measurement&)> report) noexcept {
+	concurrency::ThreadPool pool { std::min(threads, chains) };
+
+	pool.run(chains, [this, &report](int chain) {
+		auto cfg = configuration;
+		cfg.seed = seed(chain);
+		auto quiet = log.limit(diagnostics::Level::warning);
+		statistics::StreamingAutoCorrelation xsquares { window };
+		Harmonic sim { cfg, quiet };
+
+		const auto completed = sim.run([chain, &report, &xsquares](const Measurement& measurement) {
+			report(chain, measurement);
+			xsquares.add(measurement.x_square);
+		});
+
+		if (!completed) {
+			chain_results[chain] = failure(sim.steps());
+			return;
+		}
+
+		chain_results[chain] = ChainResult {
+			sim.compute_acceptance(),
+			sim.compute_x(),
+			sim.compute_x_square(),
+			xsquares.compute(),
+			sim.steps(),
+			false
+		};
+	});
+}
+
+void physics::Ensemble::run_batches(std::function<void(int, const Measurement&)> report) noexcept {
+	const auto batches = (chains + batch - 1) / batch;
+	concurrency::ThreadPool pool { std::min(threads, batches) };
+
+	pool.run(batches, [this, &report](int index) {
+		const auto first = index * batch;
+		const auto k = std::min(batch, chains - first);
+		auto quiet = log.limit(diagnostics::Level::warning);
+		std::vector<int> seeds { };
+		std::vector<statistics::StreamingAutoCorrelation> xsquares(k, statistics::StreamingAutoCorrelation { window });
+
+		for (int r = 0; r < k; ++r)
+			seeds.push_back(seed(first + r));
+
+		BatchHarmonic sim { configuration, seeds, quiet };
+
+		const auto completed = sim.run([first, &report, &xsquares](int replica, const Measurement& measurement) {
+			report(first + replica, measurement);
+			xsquares[replica].add(measurement.x_square);
+		});
+
+		for (int r = 0; r < k; ++r) {
+			if (!completed) {
+				chain_results[first + r] = failure(sim.steps());
+				continue;
+			}
+
+			chain_results[first + r] = ChainResult {
+				sim.compute_acceptance(r),
+				sim.compute_x(r),
+				sim.compute_x_square(r),
+				xsquares[r].compute(),
+				sim.steps(),
+				false
+			};
+		}
+	});
+}
+
+const std::vector<physics::ChainResult>& physics::Ensemble::results() const noexcept {
+	return chain_results;
+}
+
+statistics::Observable<double> physics::Ensemble::combine(std::function<double(const ChainResult&)> select) const noexcept {
+	using std::sqrt;
+
+	const auto n = static_cast<double>(chain_results.size());
+	auto sum = 0.0;
+	auto var = 0.0;
+
+	for (const auto& result : chain_results)
+		sum += select(result);
+
+	const auto mean = sum / n;
+
+	for (const auto& result : chain_results)
+		var += (select(result) - mean) * (select(result) - mean);
+
+	const auto error = n > 1.0 ? sqrt(var / (n * (n - 1.0))) : 0.0;
+	return statistics::Observable<double> { mean, error };
+}
+
+statistics::Observable<double> physics::Ensemble::compute_acceptance() const noexcept {
+	return combine([](const ChainResult& r) { return r.acceptance; });
+}
+
+statistics::Observable<double> physics::Ensemble::compute_x() const noexcept {
+	return combine([](const ChainResult& r) { return r.x; });
+}
+
+statistics::Observable<double> physics::Ensemble::compute_x_square() const noexcept {
+	return combine([](const ChainResult& r) { return r.x_square; });
+}
+
+statistics::Observable<double> physics::Ensemble::compute_tau() const noexcept {
+	using std::sqrt;
+
+	const auto n = static_cast<double>(chain_results.size());
+	const auto tau = combine([](const ChainResult& r) { return r.tau.mean; });
+	auto var = 0.0;
+
+	for (const auto& result : chain_results)
+		var += result.tau.uncertainty * result.tau.uncertainty;
+
+	const auto within = sqrt(var) / n;
+	return statistics::Observable<double> { tau.mean, std::max(tau.uncertainty, within) };
+}
@@ -0,0 +1,225 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "fourier.h"
+#include <cmath>
+#include <utility>
+
+using std::size_t;
+using std::complex;
+
+/**
+* Multiplies two complex numbers without the special treatment of infinities by std::complex.
+*
+* @param The first factor.
+* @param The second factor.
+* @return The product.
+*/
+inline complex<double> multiply(const complex<double>& a, const complex<double>& b) noexcept {
+	return complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+/**
+* Checks if the given length is a power of 2.
+*
+* @param The length.
+* @return True if the radix-2 transform can be used.
+*/
+inline bool is_power_of_two(size_t n) noexcept {
+	return n >= 2 && (n & (n - 1)) == 0;
+}
+
+numerics::FourierTransform::FourierTransform(size_t size) noexcept :
+	n(size),
+	m(is_power_of_two(size) ? size / 2 : next_power_of_two(2 * size - 1)),
+	radix(is_power_of_two(size)),
+	bitrev(m),
+	twiddles(m),
+	conjugates(m),
+	rotations(radix ? m : 0),
+	buffer(radix ? m + 1 : m),
+	chirp(radix ? 0 : n),
+	kernel(radix ? 0 : m) {
+	using std::polar;
+	using std::conj;
+	const auto pi = std::acos(-1.0);
+	auto bits = 0;
+
+	while ((size_t(1) << bits) < m)
+		++bits;
+
+	for (size_t i = 0; i < m; ++i) {
+		size_t r = 0;
+
+		for (int b = 0; b < bits; ++b)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+
+		bitrev[i] = r;
+	}
+
+	// The twiddles of the stage with butterflies of length 2h are stored contiguously from index h - 1.
+	for (size_t half = 1; half < m; half <<= 1) {
+		for (size_t j = 0; j < half; ++j) {
+			twiddles[half - 1 + j] = polar(1.0, -pi * static_cast<double>(j) / static_cast<double>(half));
+			conjugates[half - 1 + j] = conj(twiddles[half - 1 + j]);
+		}
+	}
+
+	for (size_t k = 0; k < rotations.size(); ++k)
+		rotations[k] = polar(1.0, -2.0 * pi * static_cast<double>(k) / static_cast<double>(n));
+
+	if (!radix) {
+		// The chirp w_j = exp(-iπ j² / n), where j² is reduced modulo 2n to keep the phase accurate.
+		for (size_t j = 0; j < n; ++j)
+			chirp[j] = polar(1.0, -pi * static_cast<double>((j * j) % (2 * n)) / static_cast<double>(n));
+
+		const auto scale = 1.0 / static_cast<double>(m);
+		kernel[0] = conj(chirp[0]) * scale;
+
+		for (size_t j = 1; j < n; ++j)
+			kernel[j] = kernel[m - j] = conj(chirp[j]) * scale;
+
+		transform(kernel.data(), false);
+	}
+}
+
+size_t numerics::FourierTransform::size() const noexcept {
+	return n;
+}
+
+size_t numerics::FourierTransform::next_power_of_two(size_t n) noexcept {
+	size_t p = 2;
+
+	while (p < n)
+		p <<= 1;
+
+	return p;
+}
+
+void numerics::FourierTransform::transform(complex<double>* data, bool backward) const noexcept {
+	using std::swap;
+
+	for (size_t i = 0; i < m; ++i) {
+		if (i < bitrev[i])
+			swap(data[i], data[bitrev[i]]);
+	}
+
+	for (size_t len = 2; len <= m; len <<= 1) {
+		const auto half = len / 2;
+		const auto w = (backward ? conjugates.data() : twiddles.data()) + half - 1;
+
+		for (size_t start = 0; start < m; start += len) {
+			for (size_t j = 0; j < half; ++j) {
+				const auto u = data[start + j];
+				const auto v = multiply(data[start + j + half], w[j]);
+				data[start + j] = u + v;
+				data[start + j + half] = u - v;
+			}
+		}
+	}
+}
+
+void numerics::FourierTransform::bluestein() noexcept {
+	for (size_t j = 0; j < n; ++j)
+		buffer[j] = multiply(buffer[j], chirp[j]);
+
+	for (size_t j = n; j < m; ++j)
+		buffer[j] = 0.0;
+
+	transform(buffer.data(), false);
+
+	for (size_t k = 0; k < m; ++k)
+		buffer[k] = multiply(buffer[k], kernel[k]);
+
+	transform(buffer.data(), true);
+
+	for (size_t k = 0; k < n; ++k)
+		buffer[k] = multiply(buffer[k], chirp[k]);
+}
+
+void numerics::FourierTransform::forward(const double* input, complex<double>* output) noexcept {
+	using std::conj;
+	const complex<double> i { 0.0, 1.0 };
+
+	if (!radix) {
+		for (size_t j = 0; j < n; ++j)
+			buffer[j] = input[j];
+
+		bluestein();
+
+		for (size_t k = 0; k <= n / 2; ++k)
+			output[k] = buffer[k];
+
+		return;
+	}
+
+	for (size_t k = 0; k < m; ++k)
+		buffer[k] = complex<double>(input[2 * k], input[2 * k + 1]);
+
+	transform(buffer.data(), false);
+	buffer[m] = buffer[0];
+
+	for (size_t k = 0; k <= m; ++k) {
+		const auto z = buffer[k];
+		const auto zc = conj(buffer[m - k]);
+		const auto even = 0.5 * (z + zc);
+		const auto odd = multiply(-0.5 * i, z - zc);
+		output[k] = even + (k < m ? multiply(rotations[k], odd) : -odd);
+	}
+}
+
+void numerics::FourierTransform::inverse(const complex<double>* input, double* output) noexcept {
+	using std::conj;
+	const complex<double> i { 0.0, 1.0 };
+
+	if (!radix) {
+		// The real part of the backward transform equals the real part of the forward transform of the conjugate.
+		const auto scale = 1.0 / static_cast<double>(n);
+
+		for (size_t k = 0; k <= n / 2; ++k)
+			buffer[k] = conj(input[k]);
+
+		for (size_t k = n / 2 + 1; k < n; ++k)
+			buffer[k] = input[n - k];
+
+		bluestein();
+
+		for (size_t j = 0; j < n; ++j)
+			output[j] = buffer[j].real() * scale;
+
+		return;
+	}
+
+	const auto scale = 1.0 / static_cast<double>(m);
+
+	for (size_t k = 0; k < m; ++k) {
+		const auto x = input[k];
+		const auto xc = conj(input[m - k]);
+		const auto even = 0.5 * (x + xc);
+		const auto odd = multiply(0.5 * (x - xc), conj(rotations[k]));
+		buffer[k] = even + multiply(i, odd);
+	}
+
+	transform(buffer.data(), true);
+
+	for (size_t k = 0; k < m; ++k) {
+		output[2 * k] = buffer[k].real() * scale;
+		output[2 * k + 1] = buffer[k].imag() * scale;
+	}
+}
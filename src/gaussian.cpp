@@ -0,0 +1,240 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "gaussian.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace {
+	const std::uint64_t one_bits = 0x3FF0000000000000;
+	const std::uint64_t mantissa_bits = 0x000FFFFFFFFFFFFF;
+	const std::uint64_t sign_bit = 0x8000000000000000;
+	const std::uint64_t sqrt2_bits = 0x3FF6A09E667F3BCD;
+	const std::uint64_t magic_bits = 0x4330000000000000;
+	const double magic = 4503599627370496.0;
+	const double ln2 = 0.693147180559945309417232121458;
+	const double quarter_pi = 0.785398163397448309615660845820;
+
+	inline double to_double(std::uint64_t bits) noexcept {
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	inline std::uint64_t to_bits(double value) noexcept {
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	/**
+	* Computes -2 ln u for u in (0, 1] given by 52 random bits, where the mantissa is reduced to
+	* [√½, √2) and the logarithm of the mantissa is given by the series of 2 artanh((m - 1) / (m + 1)).
+	*
+	* @param The random word.
+	* @return The squared radius of the Box-Muller transform.
+	*/
+	inline double square_radius(std::uint64_t word) noexcept {
+		const auto u = 2.0 - to_double((word >> 12) | one_bits);
+		const auto bits = to_bits(u);
+		auto mantissa = (bits & mantissa_bits) | one_bits;
+		const auto big = static_cast<std::uint64_t>(mantissa > sqrt2_bits);
+		mantissa -= big << 52;
+		const auto exponent = to_double(magic_bits + (bits >> 52) + big) - (magic + 1023.0);
+		const auto m = to_double(mantissa);
+		const auto s = (m - 1.0) / (m + 1.0);
+		const auto s2 = s * s;
+		auto series = 1.0 / 19.0;
+		series = series * s2 + 1.0 / 17.0;
+		series = series * s2 + 1.0 / 15.0;
+		series = series * s2 + 1.0 / 13.0;
+		series = series * s2 + 1.0 / 11.0;
+		series = series * s2 + 1.0 / 9.0;
+		series = series * s2 + 1.0 / 7.0;
+		series = series * s2 + 1.0 / 5.0;
+		series = series * s2 + 1.0 / 3.0;
+		series = series * s2 + 1.0;
+		return -2.0 * (exponent * ln2 + 2.0 * s * series);
+	}
+
+	/**
+	* Replaces a block of values by their square roots. The intrinsics are used, as std::sqrt
+	* may set errno and thus prevents the vectorization of the loop.
+	*
+	* @param The non-negative values.
+	*/
+	inline void square_roots(double* values) noexcept {
+		using numerics::Gaussian;
+#if defined(__AVX512F__)
+		for (int k = 0; k < Gaussian::block_size; k += 8)
+			_mm512_storeu_pd(values + k, _mm512_maskz_sqrt_pd(0xFF, _mm512_loadu_pd(values + k)));
+#elif defined(__AVX__)
+		for (int k = 0; k < Gaussian::block_size; k += 4)
+			_mm256_storeu_pd(values + k, _mm256_sqrt_pd(_mm256_loadu_pd(values + k)));
+#else
+		for (int k = 0; k < Gaussian::block_size; ++k)
+			values[k] = std::sqrt(values[k]);
+#endif
+	}
+
+	/**
+	* Computes the Box-Muller transform of a block of pairs of random words.
+	*
+	* @param The random words of the radii.
+	* @param The random words of the angles.
+	* @param The target for the cosine parts.
+	* @param The target for the sine parts.
+	*/
+	void transform_block(const std::uint64_t* radii, const std::uint64_t* angles, double* cosines, double* sines) noexcept {
+		using numerics::Gaussian;
+		double radius[Gaussian::block_size];
+
+		for (int k = 0; k < Gaussian::block_size; ++k)
+			radius[k] = square_radius(radii[k]);
+
+		square_roots(radius);
+
+		for (int k = 0; k < Gaussian::block_size; ++k) {
+			// The upper two bits select the quadrant, the next 52 bits the angle x in [-π/4, π/4).
+			const auto quadrant = angles[k] >> 62;
+			const auto x = (to_double(((angles[k] << 2) >> 12) | one_bits) - 1.5) * (2.0 * quarter_pi);
+			const auto x2 = x * x;
+			auto sine = -1.0 / 1307674368000.0;
+			sine = sine * x2 + 1.0 / 6227020800.0;
+			sine = sine * x2 - 1.0 / 39916800.0;
+			sine = sine * x2 + 1.0 / 362880.0;
+			sine = sine * x2 - 1.0 / 5040.0;
+			sine = sine * x2 + 1.0 / 120.0;
+			sine = sine * x2 - 1.0 / 6.0;
+			sine = (sine * x2) * x + x;
+			auto cosine = 1.0 / 20922789888000.0;
+			cosine = cosine * x2 - 1.0 / 87178291200.0;
+			cosine = cosine * x2 + 1.0 / 479001600.0;
+			cosine = cosine * x2 - 1.0 / 3628800.0;
+			cosine = cosine * x2 + 1.0 / 40320.0;
+			cosine = cosine * x2 - 1.0 / 720.0;
+			cosine = cosine * x2 + 1.0 / 24.0;
+			cosine = cosine * x2 - 0.5;
+			cosine = cosine * x2 + 1.0;
+
+			// Rotating (cos x, sin x) by a multiple of π/2 swaps the parts and flips their signs.
+			const auto swap = 0 - (quadrant & 1);
+			const auto c = to_bits(cosine);
+			const auto s = to_bits(sine);
+			const auto first = ((c & ~swap) | (s & swap)) ^ (((quadrant + 1) & 2) << 62);
+			const auto second = ((s & ~swap) | (c & swap)) ^ ((quadrant & 2) << 62);
+			cosines[k] = radius[k] * to_double(first);
+			sines[k] = radius[k] * to_double(second);
+		}
+	}
+}
+
+numerics::Gaussian::Gaussian() noexcept {
+	for (auto& words : state)
+		words.fill(0);
+
+	repair();
+}
+
+void numerics::Gaussian::operator()(double* target, int n) noexcept {
+	std::uint64_t radii[block_size];
+	std::uint64_t angles[block_size];
+
+	for (int first = 0; first < n; first += 2 * block_size) {
+		next(radii, angles);
+		const auto count = n - first < 2 * block_size ? n - first : 2 * block_size;
+		transform(target + first, radii, angles, count);
+	}
+}
+
+void numerics::Gaussian::transform(double* target, const std::uint64_t* radii, const std::uint64_t* angles, int n) noexcept {
+	double cosines[block_size];
+	double sines[block_size];
+	std::uint64_t r[block_size];
+	std::uint64_t a[block_size];
+
+	for (int first = 0; 2 * first < n; first += block_size) {
+		const auto pairs = (n + 1) / 2 - first < block_size ? (n + 1) / 2 - first : block_size;
+		auto u = radii + first;
+		auto v = angles + first;
+
+		// An incomplete block is padded, as the transform always works on full blocks.
+		if (pairs < block_size) {
+			std::memcpy(r, u, pairs * sizeof(std::uint64_t));
+			std::memcpy(a, v, pairs * sizeof(std::uint64_t));
+			std::memset(r + pairs, 0, (block_size - pairs) * sizeof(std::uint64_t));
+			std::memset(a + pairs, 0, (block_size - pairs) * sizeof(std::uint64_t));
+			u = r;
+			v = a;
+		}
+
+		transform_block(u, v, cosines, sines);
+		const auto values = n - 2 * first;
+
+		for (int k = 0; k < pairs; ++k) {
+			target[2 * (first + k)] = cosines[k];
+
+			if (2 * k + 1 < values)
+				target[2 * (first + k) + 1] = sines[k];
+		}
+	}
+}
+
+void numerics::Gaussian::next(std::uint64_t* radii, std::uint64_t* angles) noexcept {
+	// The state is copied, such that it can be kept in registers, as the targets could alias it.
+	std::uint64_t s0[lanes];
+	std::uint64_t s1[lanes];
+	std::uint64_t s2[lanes];
+	std::uint64_t s3[lanes];
+	std::memcpy(s0, state[0].data(), sizeof(s0));
+	std::memcpy(s1, state[1].data(), sizeof(s1));
+	std::memcpy(s2, state[2].data(), sizeof(s2));
+	std::memcpy(s3, state[3].data(), sizeof(s3));
+
+	for (int word = 0; word < 2 * block_size; word += lanes) {
+		auto target = word < block_size ? radii + word : angles + word - block_size;
+
+		for (int l = 0; l < lanes; ++l) {
+			target[l] = s0[l] + s3[l];
+			const auto t = s1[l] << 17;
+			s2[l] ^= s0[l];
+			s3[l] ^= s1[l];
+			s1[l] ^= s2[l];
+			s0[l] ^= s3[l];
+			s2[l] ^= t;
+			s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+		}
+	}
+
+	std::memcpy(state[0].data(), s0, sizeof(s0));
+	std::memcpy(state[1].data(), s1, sizeof(s1));
+	std::memcpy(state[2].data(), s2, sizeof(s2));
+	std::memcpy(state[3].data(), s3, sizeof(s3));
+}
+
+void numerics::Gaussian::repair() noexcept {
+	for (int l = 0; l < lanes; ++l) {
+		if ((state[0][l] | state[1][l] | state[2][l] | state[3][l]) == 0)
+			state[0][l] = 0x9E3779B97F4A7C15 * static_cast<std::uint64_t>(l + 1);
+	}
+}
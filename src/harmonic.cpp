@@ -18,86 +18,192 @@
 */
 
 #include "harmonic.h"
+#include "adaptation.h"
+#include "profiling.h"
+#include <stdexcept>
 
-physics::Harmonic::Harmonic(const physics::Configuration& cfg, std::ostream& info, std::ostream& warn) noexcept : 
+physics::Harmonic::Harmonic(const physics::Configuration& cfg, diagnostics::Logger& log) noexcept : 
 	ntherm(cfg.ntherm),
 	nmeas(cfg.nmeas),
-	info(info),
-	warn(warn),
+	done(0),
+	resumed(false),
+	target(cfg.target),
+	delta(0.0),
+	log(log),
 	rng(cfg.seed),
 	dist(0.0, 1.0),
-	lattice(rng, cfg.nt, cfg.nstep, cfg.tau, cfg.omega_square, cfg.lambda),
+	philox(static_cast<std::uint32_t>(cfg.seed)),
+	counter(cfg.engine == numerics::Engine::philox),
+	trajectory(0),
+	lattice(rng, cfg.nt, Integrator { cfg.integrator, cfg.nstep, cfg.tau, cfg.omelyan, cfg.substeps }, cfg.omega_square, cfg.lambda, cfg.fourier, cfg.dimensions, cfg.domains),
 	xsm(0.0),
 	xsqm(0.0),
-	acr(0.0) {
+	acr(0.0),
+	configuration(cfg) {
+	if (counter)
+		lattice.generator(philox);
+
+	if (lattice.domains() < cfg.domains)
+		log.warning("The lattice is decomposed into ", lattice.domains(), " domains only.");
+}
+
+bool physics::Harmonic::run(std::function<void(const physics::Measurement&)> report) noexcept {
+	return run(report, 0, nullptr);
+}
+
+bool physics::Harmonic::run(std::function<void(const physics::Measurement&)> report, int every, std::function<void()> checkpoint) noexcept {
+	if (!resumed) {
+		init();
+
+		if (!thermalize())
+			return false;
+
+		if (checkpoint)
+			checkpoint();
+	}
+
+	measure(report, every, checkpoint);
+	return true;
+}
+
+void physics::Harmonic::save(io::Checkpoint& checkpoint) const noexcept {
+	checkpoint.put(configuration.nt);
+	checkpoint.put(configuration.dimensions);
+	checkpoint.put(configuration.omega_square);
+	checkpoint.put(configuration.lambda);
+	checkpoint.put(configuration.tau);
+	checkpoint.put(configuration.nstep);
+	checkpoint.put(static_cast<int>(configuration.integrator));
+	checkpoint.put(configuration.omelyan);
+	checkpoint.put(configuration.substeps);
+	checkpoint.put(configuration.seed);
+	checkpoint.put(static_cast<int>(configuration.engine));
+	checkpoint.put(configuration.fourier);
+	checkpoint.put(done);
+	checkpoint.put(xsm);
+	checkpoint.put(xsqm);
+	checkpoint.put(acr);
+	checkpoint.put_state(rng);
+	checkpoint.put_state(dist);
+	checkpoint.put(trajectory);
+	lattice.save(checkpoint);
 }
 
-void physics::Harmonic::run(std::function<void(int, double, double, double)> report) noexcept {
-	init();
-	thermalize();
-	measure(report);
+void physics::Harmonic::load(io::Checkpoint& checkpoint) {
+	// The configured number of steps is compared, as the stored lattice carries the adapted one.
+	if (checkpoint.get<int>() != configuration.nt || checkpoint.get<int>() != configuration.dimensions ||
+		checkpoint.get<double>() != configuration.omega_square || checkpoint.get<double>() != configuration.lambda ||
+		checkpoint.get<double>() != configuration.tau || checkpoint.get<int>() != configuration.nstep ||
+		checkpoint.get<int>() != static_cast<int>(configuration.integrator) || checkpoint.get<double>() != configuration.omelyan ||
+		checkpoint.get<int>() != configuration.substeps || checkpoint.get<int>() != configuration.seed ||
+		checkpoint.get<int>() != static_cast<int>(configuration.engine) || checkpoint.get<bool>() != configuration.fourier)
+		throw std::runtime_error("The checkpoint does not match the configuration of the simulation.");
+
+	done = checkpoint.get<int>();
+	xsm = checkpoint.get<double>();
+	xsqm = checkpoint.get<double>();
+	acr = checkpoint.get<double>();
+	checkpoint.get_state(rng);
+	checkpoint.get_state(dist);
+	trajectory = checkpoint.get<std::uint64_t>();
+	lattice.load(checkpoint);
+	resumed = true;
+	log.info("Resuming with measurement ", done, " ...");
 }
 
 void physics::Harmonic::init() noexcept {
+	// The initial trajectories are not checked, hence they could diverge for a step size that still needs to be adapted.
+	if (target > 0.0)
+		return;
+
 	for (int n = 0; n < 10; ++n) {
 		lattice.randomize();
 		lattice.integrate();
 	}
 }
 
-void physics::Harmonic::thermalize() noexcept {
-	using std::endl;
-	info << "Running thermalization ..." << endl;
+bool physics::Harmonic::thermalize() noexcept {
+	using diagnostics::Level;
+	log.info("Running thermalization ...");
+	diagnostics::Progress progress { log, "Thermalization", ntherm };
+	DualAveraging adaptation { target, lattice.step_size() };
+	const auto adapting = target > 0.0;
 	auto arate = 0.0;
 
 	for (int n = 0; n < ntherm; ++n) {
 		const auto accepted = step();
+
+		if (adapting) {
+			const auto probability = delta > 0.0 ? exp(-delta) : (delta <= 0.0 ? 1.0 : 0.0);
+			lattice.step_size(adaptation.update(probability));
+		}
+
 		const auto xs = lattice.x_average();
 		const auto xsq = lattice.x_square_average();
-		info << "Init-Update [" << n << "]" << endl;
-		info << "acc  = " << accepted << endl;
-		info << "<x>  = " << xs << endl;
-		info << "<x²> = " << xsq << endl;
+
+		if (log.enabled(Level::debug))
+			log.debug("Init-Update [", n, "]\nacc  = ", accepted, "\n<x>  = ", xs, "\n<x²> = ", xsq);
+
+		progress.update(accepted, xs, xsq);
 		arate += accepted;
 	}
 
-	info << "Thermalization finished!" << endl;
+	progress.finish();
+	log.info("Thermalization finished!");
 
-	if (4.0 * arate < ntherm) {
-		warn << "Bad acceptance rate in thermalisation!" << endl;
-		exit(1);
+	if (adapting) {
+		lattice.step_size(adaptation.average());
+		log.info("Adapted the step size to ε = ", lattice.step_size(), " with ", lattice.steps(), " steps for an acceptance of ", target, ".");
+
+		if (4.0 * arate < ntherm)
+			log.warning("Low acceptance rate during the adaptation of the step size!");
+	} else if (4.0 * arate < ntherm) {
+		log.error("Bad acceptance rate in thermalisation!");
+		return false;
 	}
+
+	return true;
 }
 
-void physics::Harmonic::measure(std::function<void(int, double, double, double)> report) noexcept {
-	using std::endl;
-	info << "Starting measurements ..." << endl;
+void physics::Harmonic::measure(std::function<void(const physics::Measurement&)> report, int every, std::function<void()> checkpoint) noexcept {
+	using diagnostics::Level;
+	log.info("Starting measurements ...");
+	diagnostics::Progress progress { log, "Measurements", nmeas - done };
 
-	for (int n = 0; n < nmeas; ++n) { 
+	for (int n = done; n < nmeas; ++n) { 
 		const auto accepted = step();
-		const auto xs = lattice.x_average();
-		const auto xsq = lattice.x_square_average();
-		const auto act = lattice.action_average();
-		info << "Meas-Update [" << n << "]" << endl;
-		info << "acc  = " << accepted << endl;
-		info << "<x>  = " << xs << endl;
-		info << "<x²> = " << xsq << endl;
-		report(n, xs, xsq, act);
+		const auto xs = PROFILE_CALL(observables, lattice.x_average());
+		const auto xsq = PROFILE_CALL(observables, lattice.x_square_average());
+		const auto act = PROFILE_CALL(observables, lattice.action_average());
+
+		if (log.enabled(Level::debug))
+			log.debug("Meas-Update [", n, "]\nacc  = ", accepted, "\n<x>  = ", xs, "\n<x²> = ", xsq);
+
+		PROFILE_CALL(report, report(physics::Measurement { n, xs, xsq, act, accepted }));
+		progress.update(accepted, xs, xsq);
 		acr += accepted;
 		xsm += xs;
 		xsqm += xsq;
+		done = n + 1;
+
+		if (checkpoint && every > 0 && done % every == 0 && done < nmeas)
+			checkpoint();
 	}
 
-	info << "Measurements finished!" << endl;
+	progress.finish();
+	log.info("Measurements finished!");
 }
 
 bool physics::Harmonic::step() noexcept {
-	lattice.randomize();
+	PROFILE_CALL(randomize, lattice.randomize());
 	lattice.store();
-	const auto a = lattice.hamilton();
-	lattice.integrate();
-	const auto b = lattice.hamilton();
-	const auto accept = metropolis(b - a);
+	const auto a = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_CALL(integrate, lattice.integrate());
+	const auto b = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_SCOPE(metropolis);
+	delta = b - a;
+	const auto accept = metropolis(delta);
+	++trajectory;
 
 	if (!accept)
 		lattice.restore();
@@ -106,6 +212,9 @@ bool physics::Harmonic::step() noexcept {
 }
 
 bool physics::Harmonic::metropolis(double r) noexcept {
+	if (counter)
+		return r <= 0.0 || philox.uniform(trajectory, numerics::Philox::Purpose::metropolis) <= exp(-r);
+
 	return r <= 0.0 || dist(rng) <= exp(-r);
 }
 
@@ -120,3 +229,11 @@ double physics::Harmonic::compute_x() const noexcept {
 double physics::Harmonic::compute_x_square() const noexcept {
 	return xsqm / static_cast<double>(nmeas);
 }
+
+int physics::Harmonic::steps() const noexcept {
+	return lattice.steps();
+}
+
+double physics::Harmonic::step_size() const noexcept {
+	return lattice.step_size();
+}
@@ -0,0 +1,378 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "history.h"
+#include <cstring>
+#include <stdexcept>
+#include <chrono>
+#include <utility>
+
+#ifdef _WIN32
+#include <iterator>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using std::size_t;
+
+static_assert(sizeof(io::FileHeader) == 128, "The file header needs to have a fixed size.");
+static_assert(sizeof(io::ChunkHeader) == 16, "The chunk header needs to have a fixed size.");
+
+const char binary_magic[8] = { 'H', 'A', 'R', 'M', 'O', 'S', 'C', '\0' };
+
+inline size_t padded(size_t bytes) noexcept {
+	return (bytes + 7) & ~size_t(7);
+}
+
+inline void backoff(int& spins) noexcept {
+	if (++spins < 64)
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+/**
+* Truncates an existing file, such that it can be continued from the given size.
+*
+* @param The name of the file.
+* @param The new size of the file.
+*/
+inline void truncate_file(const std::string& name, std::uint64_t size) noexcept {
+#ifdef _WIN32
+	int fd = -1;
+
+	if (::_sopen_s(&fd, name.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, 0) == 0) {
+		::_chsize_s(fd, static_cast<__int64>(size));
+		::_close(fd);
+	}
+#else
+	::truncate(name.c_str(), static_cast<off_t>(size));
+#endif
+}
+
+inline size_t chunk_bytes(size_t count) noexcept {
+	return sizeof(io::ChunkHeader) + 32 * count + padded(count);
+}
+
+io::TextWriter::TextWriter(const std::string& name, std::uint64_t offset) noexcept :
+	output() {
+	if (offset > 0) {
+		truncate_file(name, offset);
+		output.open(name, std::ios::app | std::ios::ate);
+	} else
+		output.open(name);
+}
+
+void io::TextWriter::write(const physics::Measurement& m) noexcept {
+	output << m.n << '\t' << m.x << '\t' << m.x_square << '\t' << m.action << '\n';
+}
+
+void io::TextWriter::flush() noexcept {
+	output.flush();
+}
+
+void io::TextWriter::close() noexcept {
+	output.close();
+}
+
+std::uint64_t io::TextWriter::position() noexcept {
+	return static_cast<std::uint64_t>(output.tellp());
+}
+
+io::BinaryWriter::BinaryWriter(const std::string& name, const physics::Configuration& cfg, std::uint64_t offset, size_t capacity) noexcept :
+	output(),
+	capacity(capacity) {
+	index.reserve(capacity);
+	x.reserve(capacity);
+	x_square.reserve(capacity);
+	action.reserve(capacity);
+	accepted.reserve(padded(capacity));
+
+	if (offset > 0) {
+		truncate_file(name, offset);
+		output.open(name, std::ios::binary | std::ios::app | std::ios::ate);
+		return;
+	}
+
+	output.open(name, std::ios::binary);
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+	header.version = binary_version;
+	header.chunk_capacity = static_cast<std::uint32_t>(capacity);
+	header.nt = cfg.nt;
+	header.nmeas = cfg.nmeas;
+	header.ntherm = cfg.ntherm;
+	header.nstep = cfg.nstep;
+	header.seed = cfg.seed;
+	header.integrator = static_cast<std::int32_t>(cfg.integrator);
+	header.omega_square = cfg.omega_square;
+	header.lambda = cfg.lambda;
+	header.tau = cfg.tau;
+	header.omelyan = cfg.omelyan;
+	header.substeps = cfg.substeps;
+	header.fourier = cfg.fourier ? 1 : 0;
+	header.target = cfg.target;
+	header.engine = static_cast<std::int32_t>(cfg.engine);
+	header.dimensions = cfg.dimensions;
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+io::BinaryWriter::~BinaryWriter() noexcept {
+	close();
+}
+
+void io::BinaryWriter::write(const physics::Measurement& m) noexcept {
+	index.push_back(m.n);
+	x.push_back(m.x);
+	x_square.push_back(m.x_square);
+	action.push_back(m.action);
+	accepted.push_back(m.accepted ? 1 : 0);
+
+	if (index.size() == capacity)
+		flush();
+}
+
+void io::BinaryWriter::flush() noexcept {
+	const auto count = index.size();
+
+	if (count > 0) {
+		const ChunkHeader chunk { static_cast<std::uint64_t>(count), 0 };
+		accepted.resize(padded(count), 0);
+		output.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+		output.write(reinterpret_cast<const char*>(index.data()), count * sizeof(std::int64_t));
+		output.write(reinterpret_cast<const char*>(x.data()), count * sizeof(double));
+		output.write(reinterpret_cast<const char*>(x_square.data()), count * sizeof(double));
+		output.write(reinterpret_cast<const char*>(action.data()), count * sizeof(double));
+		output.write(reinterpret_cast<const char*>(accepted.data()), accepted.size());
+		index.clear();
+		x.clear();
+		x_square.clear();
+		action.clear();
+		accepted.clear();
+	}
+
+	output.flush();
+}
+
+void io::BinaryWriter::close() noexcept {
+	if (output.is_open()) {
+		flush();
+		output.close();
+	}
+}
+
+std::uint64_t io::BinaryWriter::position() noexcept {
+	return static_cast<std::uint64_t>(output.tellp());
+}
+
+io::AsyncWriter::AsyncWriter(std::unique_ptr<HistoryWriter> target, size_t capacity) noexcept :
+	target(std::move(target)),
+	queue(capacity),
+	pushed(0),
+	written(0),
+	stopping(false),
+	worker(&AsyncWriter::drain, this) {
+}
+
+io::AsyncWriter::~AsyncWriter() noexcept {
+	close();
+}
+
+void io::AsyncWriter::write(const physics::Measurement& m) noexcept {
+	auto spins = 0;
+
+	while (!queue.try_push(m))
+		backoff(spins);
+
+	++pushed;
+}
+
+void io::AsyncWriter::flush() noexcept {
+	auto spins = 0;
+
+	while (written.load(std::memory_order_acquire) != pushed)
+		backoff(spins);
+
+	target->flush();
+}
+
+void io::AsyncWriter::close() noexcept {
+	if (worker.joinable()) {
+		stopping.store(true, std::memory_order_release);
+		worker.join();
+		target->close();
+	}
+}
+
+std::uint64_t io::AsyncWriter::position() noexcept {
+	return target->position();
+}
+
+void io::AsyncWriter::drain() noexcept {
+	physics::Measurement m;
+	auto spins = 0;
+
+	for (;;) {
+		if (queue.try_pop(m)) {
+			target->write(m);
+			written.fetch_add(1, std::memory_order_release);
+			spins = 0;
+		} else if (stopping.load(std::memory_order_acquire)) {
+			if (!queue.try_pop(m))
+				return;
+
+			target->write(m);
+			written.fetch_add(1, std::memory_order_release);
+		} else
+			backoff(spins);
+	}
+}
+
+std::unique_ptr<io::HistoryWriter> io::create_writer(const std::string& format, const std::string& name, const physics::Configuration& cfg, std::uint64_t offset) noexcept {
+	std::unique_ptr<HistoryWriter> writer { };
+
+	if (format == "text")
+		writer.reset(new TextWriter(name, offset));
+	else if (format == "binary")
+		writer.reset(new BinaryWriter(name, cfg, offset));
+	else
+		return nullptr;
+
+	return std::unique_ptr<HistoryWriter>(new AsyncWriter(std::move(writer)));
+}
+
+io::HistoryReader::HistoryReader(const std::string& name) :
+	data(nullptr),
+	length(0),
+	offsets(),
+	counts(),
+	total(0) {
+#ifdef _WIN32
+	std::ifstream input { name, std::ios::binary };
+
+	if (!input)
+		throw std::runtime_error("The history file " + name + " could not be opened.");
+
+	std::vector<char> content { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+	length = content.size();
+	auto buffer = new char[length > 0 ? length : 1];
+	std::memcpy(buffer, content.data(), length);
+	data = buffer;
+#else
+	const auto fd = ::open(name.c_str(), O_RDONLY);
+	struct stat info;
+
+	if (fd < 0)
+		throw std::runtime_error("The history file " + name + " could not be opened.");
+
+	if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+		::close(fd);
+		throw std::runtime_error("The history file " + name + " is not a binary history.");
+	}
+
+	length = static_cast<size_t>(info.st_size);
+	const auto mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (mapped == MAP_FAILED)
+		throw std::runtime_error("The history file " + name + " could not be mapped.");
+
+	::madvise(mapped, length, MADV_SEQUENTIAL);
+	data = static_cast<const char*>(mapped);
+#endif
+
+	if (length < sizeof(FileHeader) || std::memcmp(header().magic, binary_magic, sizeof(binary_magic)) != 0 || header().version != binary_version) {
+		unmap();
+		throw std::runtime_error("The history file " + name + " is not a compatible binary history.");
+	}
+
+	auto offset = sizeof(FileHeader);
+
+	while (offset + sizeof(ChunkHeader) <= length) {
+		ChunkHeader chunk;
+		std::memcpy(&chunk, data + offset, sizeof(chunk));
+		const auto count = static_cast<size_t>(chunk.count);
+
+		if (count == 0 || offset + chunk_bytes(count) > length)
+			break;
+
+		offsets.push_back(offset);
+		counts.push_back(count);
+		total += count;
+		offset += chunk_bytes(count);
+	}
+}
+
+io::HistoryReader::~HistoryReader() noexcept {
+	unmap();
+}
+
+void io::HistoryReader::unmap() noexcept {
+	if (data != nullptr) {
+#ifdef _WIN32
+		delete[] data;
+#else
+		::munmap(const_cast<char*>(data), length);
+#endif
+		data = nullptr;
+	}
+}
+
+const io::FileHeader& io::HistoryReader::header() const noexcept {
+	return *reinterpret_cast<const FileHeader*>(data);
+}
+
+physics::Configuration io::HistoryReader::configuration() const noexcept {
+	const auto& h = header();
+	return physics::Configuration { h.nt, h.omega_square, h.lambda, h.nmeas, h.ntherm, h.tau, h.nstep, h.seed, static_cast<physics::Scheme>(h.integrator), h.omelyan, h.substeps, h.fourier != 0, h.target, static_cast<numerics::Engine>(h.engine), h.dimensions > 1 ? h.dimensions : 1, 1 };
+}
+
+size_t io::HistoryReader::chunks() const noexcept {
+	return offsets.size();
+}
+
+size_t io::HistoryReader::size() const noexcept {
+	return total;
+}
+
+io::Column<std::int64_t> io::HistoryReader::index(size_t chunk) const noexcept {
+	return column<std::int64_t>(chunk, 0);
+}
+
+io::Column<double> io::HistoryReader::x(size_t chunk) const noexcept {
+	return column<double>(chunk, 8);
+}
+
+io::Column<double> io::HistoryReader::x_square(size_t chunk) const noexcept {
+	return column<double>(chunk, 16);
+}
+
+io::Column<double> io::HistoryReader::action(size_t chunk) const noexcept {
+	return column<double>(chunk, 24);
+}
+
+io::Column<std::uint8_t> io::HistoryReader::accepted(size_t chunk) const noexcept {
+	return column<std::uint8_t>(chunk, 32);
+}
@@ -0,0 +1,178 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "integrator.h"
+
+constexpr double physics::Integrator::default_parameter;
+constexpr int physics::Integrator::max_steps;
+
+/**
+* A single update of a step in units of the step size.
+*/
+struct Update {
+	bool drift;
+	double coefficient;
+	double gradient;
+};
+
+/**
+* Gets the updates of a single step of a scheme.
+*
+* @param The scheme.
+* @param The tuning parameter λ of the second order Omelyan scheme.
+* @return The sequence of updates.
+*/
+std::vector<Update> pattern(physics::Scheme scheme, double lambda) noexcept {
+	using physics::Scheme;
+
+	// Position version of the fourth order minimum norm scheme (Omelyan, Mryglod, Folk).
+	const auto rho = 0.1786178958448091;
+	const auto theta = -0.06626458266981849;
+	const auto mu = 0.7123418310626054;
+
+	switch (scheme) {
+		case Scheme::omelyan2:
+			return std::vector<Update> {
+				{ true, lambda, 0.0 }, { false, 0.5, 0.0 }, { true, 1.0 - 2.0 * lambda, 0.0 }, { false, 0.5, 0.0 }, { true, lambda, 0.0 }
+			};
+
+		case Scheme::omelyan4:
+			return std::vector<Update> {
+				{ true, rho, 0.0 }, { false, mu, 0.0 }, { true, theta, 0.0 }, { false, 0.5 - mu, 0.0 }, { true, 1.0 - 2.0 * (theta + rho), 0.0 },
+				{ false, 0.5 - mu, 0.0 }, { true, theta, 0.0 }, { false, mu, 0.0 }, { true, rho, 0.0 }
+			};
+
+		case Scheme::force_gradient:
+			return std::vector<Update> {
+				{ false, 1.0 / 6.0, 0.0 }, { true, 0.5, 0.0 }, { false, 2.0 / 3.0, 1.0 / 24.0 }, { true, 0.5, 0.0 }, { false, 1.0 / 6.0, 0.0 }
+			};
+
+		default:
+			return std::vector<Update> {
+				{ true, 0.5, 0.0 }, { false, 1.0, 0.0 }, { true, 0.5, 0.0 }
+			};
+	}
+}
+
+physics::Integrator::Integrator(Scheme scheme, int nstep, double tau, double lambda, int substeps) noexcept :
+	kind(scheme),
+	nstep(nstep),
+	nsub(substeps),
+	tau(tau),
+	eps(tau / static_cast<double>(nstep)),
+	parameter(lambda),
+	ops() {
+	unroll(0, tau, nstep);
+}
+
+void physics::Integrator::unroll(int level, double length, int steps) noexcept {
+	const auto innermost = nsub == 0 || level == 1;
+	const auto force = nsub == 0 ? Force::full : (level == 0 ? Force::harmonic : Force::anharmonic);
+	const auto updates = pattern(kind, parameter);
+	const auto h = length / static_cast<double>(steps);
+
+	for (int n = 0; n < steps; ++n) {
+		for (const auto& update : updates) {
+			if (!update.drift)
+				append(false, update.coefficient * h, update.gradient * h * h, force);
+			else if (innermost)
+				append(true, update.coefficient * h, 0.0, force);
+			else
+				unroll(level + 1, update.coefficient * h, nsub);
+		}
+	}
+}
+
+void physics::Integrator::append(bool drift, double coefficient, double gradient, Force force) noexcept {
+	if (!ops.empty()) {
+		auto& last = ops.back();
+
+		if (last.drift == drift && (drift || (last.force == force && last.gradient == 0.0 && gradient == 0.0))) {
+			last.coefficient += coefficient;
+			return;
+		}
+	}
+
+	ops.push_back(Operation { drift, coefficient, gradient, drift ? Force::full : force });
+}
+
+physics::Scheme physics::Integrator::scheme() const noexcept {
+	return kind;
+}
+
+int physics::Integrator::steps() const noexcept {
+	return nstep;
+}
+
+int physics::Integrator::substeps() const noexcept {
+	return nsub;
+}
+
+double physics::Integrator::trajectory_length() const noexcept {
+	return tau;
+}
+
+physics::Integrator physics::Integrator::resize(int steps) const noexcept {
+	return Integrator { kind, steps, tau, parameter, nsub };
+}
+
+double physics::Integrator::step_size() const noexcept {
+	return eps;
+}
+
+const std::vector<physics::Operation>& physics::Integrator::operations() const noexcept {
+	return ops;
+}
+
+int physics::Integrator::force_evaluations(Force force) const noexcept {
+	auto count = 0;
+
+	for (const auto& op : ops) {
+		if (!op.drift && op.force == force)
+			count += op.gradient != 0.0 ? 2 : 1;
+	}
+
+	return count;
+}
+
+const char* physics::Integrator::name(Scheme scheme) noexcept {
+	switch (scheme) {
+		case Scheme::omelyan2:
+			return "omelyan2";
+		case Scheme::omelyan4:
+			return "omelyan4";
+		case Scheme::force_gradient:
+			return "fg";
+		default:
+			return "leapfrog";
+	}
+}
+
+bool physics::Integrator::parse(const std::string& name, Scheme& scheme) noexcept {
+	const Scheme schemes[] = { Scheme::leapfrog, Scheme::omelyan2, Scheme::omelyan4, Scheme::force_gradient };
+
+	for (const auto candidate : schemes) {
+		if (name == Integrator::name(candidate)) {
+			scheme = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,755 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+typedef __m512d vec;
+const int width = 8;
+
+inline vec load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+inline void store(double* p, vec v) noexcept { _mm512_storeu_pd(p, v); }
+inline vec set1(double value) noexcept { return _mm512_set1_pd(value); }
+inline vec add(vec a, vec b) noexcept { return _mm512_add_pd(a, b); }
+inline vec mul(vec a, vec b) noexcept { return _mm512_mul_pd(a, b); }
+inline vec fmadd(vec a, vec b, vec c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+inline vec fmsub(vec a, vec b, vec c) noexcept { return _mm512_fmsub_pd(a, b, c); }
+inline vec fnmadd(vec a, vec b, vec c) noexcept { return _mm512_fnmadd_pd(a, b, c); }
+inline double reduce(vec v) noexcept {
+	double lanes[width];
+	_mm512_storeu_pd(lanes, v);
+	return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+const char* simd_name = "AVX-512";
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+typedef __m256d vec;
+const int width = 4;
+
+inline vec load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+inline void store(double* p, vec v) noexcept { _mm256_storeu_pd(p, v); }
+inline vec set1(double value) noexcept { return _mm256_set1_pd(value); }
+inline vec add(vec a, vec b) noexcept { return _mm256_add_pd(a, b); }
+inline vec mul(vec a, vec b) noexcept { return _mm256_mul_pd(a, b); }
+inline vec fmadd(vec a, vec b, vec c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+inline vec fmsub(vec a, vec b, vec c) noexcept { return _mm256_fmsub_pd(a, b, c); }
+inline vec fnmadd(vec a, vec b, vec c) noexcept { return _mm256_fnmadd_pd(a, b, c); }
+
+inline double reduce(vec v) noexcept {
+	const auto pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+const char* simd_name = "AVX2";
+#else
+typedef double vec;
+const int width = 1;
+
+inline vec load(const double* p) noexcept { return *p; }
+inline void store(double* p, vec v) noexcept { *p = v; }
+inline vec set1(double value) noexcept { return value; }
+inline vec add(vec a, vec b) noexcept { return a + b; }
+inline vec mul(vec a, vec b) noexcept { return a * b; }
+inline vec fmadd(vec a, vec b, vec c) noexcept { return a * b + c; }
+inline vec fmsub(vec a, vec b, vec c) noexcept { return a * b - c; }
+inline vec fnmadd(vec a, vec b, vec c) noexcept { return c - a * b; }
+inline double reduce(vec v) noexcept { return v; }
+
+const char* simd_name = "scalar";
+#endif
+
+/**
+* Gets the number of sites that can be processed with full vectors.
+*/
+inline int vector_sites(int n) noexcept {
+	return n - n % width;
+}
+
+using physics::kernels::Form;
+using physics::kernels::Specialization;
+
+/**
+* The number of sites per block of a fused sweep, which should keep a block of x, y and p in the cache.
+*/
+const int block_sites = 1024;
+
+inline void drift_sites(double* y, const double* x, const double* p, double eps, int n) noexcept {
+	const auto m = vector_sites(n);
+	const auto e = set1(eps);
+
+	for (int i = 0; i < m; i += width)
+		store(y + i, fmadd(e, load(p + i), load(x + i)));
+
+	for (int i = m; i < n; ++i)
+		y[i] = x[i] + eps * p[i];
+}
+
+/**
+* Changes the momenta by the force, where the anharmonic term is only evaluated for the quartic form.
+*/
+template<Form F>
+inline double kick_sites(double* p, const double* x, double osq, double lambda, double eps, int n, int stride) noexcept {
+	const auto m = vector_sites(n);
+	const auto e = set1(eps);
+	const auto o = set1(osq);
+	const auto l = set1(4.0 * lambda);
+	auto a = set1(0.0);
+
+	for (int i = 0; i < m; i += width) {
+		const auto xi = load(x + i);
+		const auto nb = add(load(x + i - stride), load(x + i + stride));
+		const auto f = F == Form::quartic ? fmsub(xi, fmadd(l, mul(xi, xi), o), nb) : fmsub(xi, o, nb);
+		const auto pi = fnmadd(e, f, load(p + i));
+		store(p + i, pi);
+		a = fmadd(pi, pi, a);
+	}
+
+	auto sum = reduce(a);
+
+	for (int i = m; i < n; ++i) {
+		const auto c = F == Form::quartic ? osq + 4.0 * lambda * x[i] * x[i] : osq;
+		const auto f = x[i] * c - (x[i - stride] + x[i + stride]);
+		p[i] -= eps * f;
+		sum += p[i] * p[i];
+	}
+
+	return sum;
+}
+
+/**
+* Computes twice the action, where the anharmonic term is only evaluated for the quartic form.
+*/
+template<Form F>
+inline double potential_sites(const double* x, double osq, double lambda, int n) noexcept {
+	const auto m = vector_sites(n);
+	const auto o = set1(osq);
+	const auto l = set1(2.0 * lambda);
+	auto a = set1(0.0);
+	auto b = set1(0.0);
+	auto i = 0;
+
+	for (; i + width < m; i += 2 * width) {
+		const auto x0 = load(x + i);
+		const auto x1 = load(x + i + width);
+		const auto n0 = add(load(x + i - 1), load(x + i + 1));
+		const auto n1 = add(load(x + i + width - 1), load(x + i + width + 1));
+		const auto c0 = F == Form::quartic ? fmadd(l, mul(x0, x0), o) : o;
+		const auto c1 = F == Form::quartic ? fmadd(l, mul(x1, x1), o) : o;
+		a = fmadd(x0, fmsub(x0, c0, n0), a);
+		b = fmadd(x1, fmsub(x1, c1, n1), b);
+	}
+
+	for (; i < m; i += width) {
+		const auto x0 = load(x + i);
+		const auto n0 = add(load(x + i - 1), load(x + i + 1));
+		const auto c0 = F == Form::quartic ? fmadd(l, mul(x0, x0), o) : o;
+		a = fmadd(x0, fmsub(x0, c0, n0), a);
+	}
+
+	auto sum = reduce(add(a, b));
+
+	for (i = m; i < n; ++i) {
+		const auto c = F == Form::quartic ? osq + 2.0 * lambda * x[i] * x[i] : osq;
+		sum += x[i] * (x[i] * c - (x[i - 1] + x[i + 1]));
+	}
+
+	return sum;
+}
+
+/**
+* Drifts all sites of a periodic lattice and kicks the momenta with the new sites in blocks, such that
+* a block is kicked while it is still in the cache. A site is kicked once its right neighbour has drifted.
+* For a fixed number of sites N the loops have constant trip counts.
+*/
+template<Form F, int N>
+double sweep_lattice(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n) noexcept {
+	const auto sites = N > 0 ? N : n;
+	const auto last = sites - 1;
+	auto kicked = 0;
+	auto sum = 0.0;
+
+	y[last] = x[last] + ex * v[last];
+	y[-1] = y[last];
+
+	for (int lo = 0; lo < last; lo += block_sites) {
+		const auto hi = std::min(lo + block_sites, last);
+		drift_sites(y + lo, x + lo, v + lo, ex, hi - lo);
+		sum += kick_sites<F>(p + kicked, y + kicked, osq, lambda, ep, hi - 1 - kicked, 1);
+		kicked = hi - 1;
+	}
+
+	y[sites] = y[0];
+	return sum + kick_sites<F>(p + kicked, y + kicked, osq, lambda, ep, sites - kicked, 1);
+}
+
+/**
+* Drifts all sites of a periodic lattice in place and computes twice the action of the new sites in blocks.
+*/
+template<Form F, int N>
+double sweep_potential_lattice(double* x, const double* v, double ex, double osq, double lambda, int n) noexcept {
+	const auto sites = N > 0 ? N : n;
+	const auto last = sites - 1;
+	auto done = 0;
+	auto sum = 0.0;
+
+	x[last] += ex * v[last];
+	x[-1] = x[last];
+
+	for (int lo = 0; lo < last; lo += block_sites) {
+		const auto hi = std::min(lo + block_sites, last);
+		drift_sites(x + lo, x + lo, v + lo, ex, hi - lo);
+		sum += potential_sites<F>(x + done, osq, lambda, hi - 1 - done);
+		done = hi - 1;
+	}
+
+	x[sites] = x[0];
+	return sum + potential_sites<F>(x + done, osq, lambda, sites - done);
+}
+
+/**
+* Drifts the sites [first, last) of a periodic lattice in blocks and kicks the momenta of the sites in
+* between, whose neighbours are in the range. The ranges with the first and the last site set the ghost cells.
+*/
+template<Form F>
+double sweep_range(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n, int first, int last) noexcept {
+	auto kicked = first + 1;
+	auto sum = 0.0;
+
+	for (int lo = first; lo < last; lo += block_sites) {
+		const auto hi = std::min(lo + block_sites, last);
+		drift_sites(y + lo, x + lo, v + lo, ex, hi - lo);
+
+		if (hi - 1 > kicked) {
+			sum += kick_sites<F>(p + kicked, y + kicked, osq, lambda, ep, hi - 1 - kicked, 1);
+			kicked = hi - 1;
+		}
+	}
+
+	if (first == 0)
+		y[n] = y[0];
+
+	if (last == n)
+		y[-1] = y[n - 1];
+
+	return sum;
+}
+
+/**
+* Drifts the sites [first, last) of a periodic lattice in place and computes twice the action of the sites in between.
+*/
+template<Form F>
+double sweep_potential_range(double* x, const double* v, double ex, double osq, double lambda, int n, int first, int last) noexcept {
+	auto done = first + 1;
+	auto sum = 0.0;
+
+	for (int lo = first; lo < last; lo += block_sites) {
+		const auto hi = std::min(lo + block_sites, last);
+		drift_sites(x + lo, x + lo, v + lo, ex, hi - lo);
+
+		if (hi - 1 > done) {
+			sum += potential_sites<F>(x + done, osq, lambda, hi - 1 - done);
+			done = hi - 1;
+		}
+	}
+
+	if (first == 0)
+		x[n] = x[0];
+
+	if (last == n)
+		x[-1] = x[n - 1];
+
+	return sum;
+}
+
+template<Form F>
+double kick_range(double* p, const double* x, double osq, double lambda, double eps, int, int first, int last) noexcept {
+	return kick_sites<F>(p + first, x + first, osq, lambda, eps, last - first, 1);
+}
+
+template<Form F>
+double potential_range(const double* x, double osq, double lambda, int, int first, int last) noexcept {
+	return potential_sites<F>(x + first, osq, lambda, last - first);
+}
+
+template<Form F, int N>
+double kick_lattice(double* p, const double* x, double osq, double lambda, double eps, int n) noexcept {
+	return kick_sites<F>(p, x, osq, lambda, eps, N > 0 ? N : n, 1);
+}
+
+template<Form F, int N>
+double potential_lattice(const double* x, double osq, double lambda, int n) noexcept {
+	return potential_sites<F>(x, osq, lambda, N > 0 ? N : n);
+}
+
+template<Form F, int N>
+Specialization specialization() noexcept {
+	return Specialization {
+		&sweep_lattice<F, N>, &sweep_potential_lattice<F, N>, &kick_lattice<F, N>, &potential_lattice<F, N>,
+		&sweep_range<F>, &sweep_potential_range<F>, &kick_range<F>, &potential_range<F>, F, N
+	};
+}
+
+/**
+* Selects the instantiation for the number of sites, where small common sizes, e.g. the default
+* of 100 sites, are fixed at compile time.
+*/
+template<Form F>
+Specialization specialization(int n) noexcept {
+	switch (n) {
+		case 16:
+			return specialization<F, 16>();
+		case 32:
+			return specialization<F, 32>();
+		case 64:
+			return specialization<F, 64>();
+		case 100:
+			return specialization<F, 100>();
+		case 128:
+			return specialization<F, 128>();
+		case 256:
+			return specialization<F, 256>();
+		default:
+			return specialization<F, 0>();
+	}
+}
+
+/**
+* The number of sites of a tile of rows, which should keep three slices of a tile of x and p in the cache.
+*/
+const int tile_sites = 8192;
+
+/**
+* Visits the rows, i.e. the contiguous first dimension, of a periodic lattice with D > 1 dimensions in tiles.
+* The dimensions 1 to D - 2 are split into tiles, while the last dimension is streamed, such that
+* the neighbouring rows of the previous slice are still in the cache when they are needed again.
+*
+* @param The extent of every dimension.
+* @param The first slice of the last dimension.
+* @param The end of the slices of the last dimension.
+* @param The visitor, which gets the offset of a row and the offsets of its neighbouring rows,
+* i.e. the rows behind in dimension 1 to D - 1 followed by the rows in front.
+*/
+template<int D, typename Visitor>
+inline void traverse(int extent, int begin, int end, Visitor visit) noexcept {
+	const auto tiled = D - 2;
+	const auto rows = std::max(1, tile_sites / extent);
+	auto tile = extent;
+
+	if (tiled > 0)
+		tile = std::max(1, std::min(extent, static_cast<int>(std::pow(static_cast<double>(rows), 1.0 / tiled))));
+
+	int stride[D];
+	int first[D];
+	int c[D];
+	int neighbours[2 * (D - 1)];
+	stride[0] = 1;
+
+	for (int k = 1; k < D; ++k)
+		stride[k] = stride[k - 1] * extent;
+
+	for (int k = 1; k <= tiled; ++k)
+		first[k] = 0;
+
+	for (;;) {
+		for (int last = begin; last < end; ++last) {
+			c[D - 1] = last;
+
+			for (int k = 1; k <= tiled; ++k)
+				c[k] = first[k];
+
+			for (;;) {
+				auto offset = 0;
+
+				for (int k = 1; k < D; ++k)
+					offset += c[k] * stride[k];
+
+				for (int k = 1; k < D; ++k) {
+					neighbours[k - 1] = c[k] == 0 ? offset + (extent - 1) * stride[k] : offset - stride[k];
+					neighbours[D - 2 + k] = c[k] == extent - 1 ? offset - (extent - 1) * stride[k] : offset + stride[k];
+				}
+
+				visit(offset, neighbours);
+				auto k = 1;
+
+				for (; k <= tiled; ++k) {
+					if (++c[k] < std::min(first[k] + tile, extent))
+						break;
+
+					c[k] = first[k];
+				}
+
+				if (k > tiled)
+					break;
+			}
+		}
+
+		auto k = 1;
+
+		for (; k <= tiled; ++k) {
+			first[k] += tile;
+
+			if (first[k] < extent)
+				break;
+
+			first[k] = 0;
+		}
+
+		if (k > tiled)
+			break;
+	}
+}
+
+/**
+* Changes the momenta of a row by the force with 2 D neighbours, where the first and the last site
+* of the row wrap around.
+*/
+template<Form F, int D>
+inline double kick_row(double* p, const double* x, const double* const* rows, int extent, double osq, double lambda, double eps) noexcept {
+	const auto e = set1(eps);
+	const auto o = set1(osq);
+	const auto l = set1(4.0 * lambda);
+	auto a = set1(0.0);
+	auto i = 1;
+
+	for (; i + width < extent; i += width) {
+		const auto xi = load(x + i);
+		auto nb = add(load(x + i - 1), load(x + i + 1));
+
+		for (int k = 0; k < 2 * (D - 1); ++k)
+			nb = add(nb, load(rows[k] + i));
+
+		const auto f = F == Form::quartic ? fmsub(xi, fmadd(l, mul(xi, xi), o), nb) : fmsub(xi, o, nb);
+		const auto pi = fnmadd(e, f, load(p + i));
+		store(p + i, pi);
+		a = fmadd(pi, pi, a);
+	}
+
+	auto sum = reduce(a);
+
+	for (; i <= extent; ++i) {
+		const auto j = i == extent ? 0 : i;
+		const auto left = j == 0 ? extent - 1 : j - 1;
+		const auto right = j == extent - 1 ? 0 : j + 1;
+		auto nb = x[left] + x[right];
+
+		for (int k = 0; k < 2 * (D - 1); ++k)
+			nb += rows[k][j];
+
+		const auto c = F == Form::quartic ? osq + 4.0 * lambda * x[j] * x[j] : osq;
+		p[j] -= eps * (x[j] * c - nb);
+		sum += p[j] * p[j];
+	}
+
+	return sum;
+}
+
+/**
+* Computes twice the action of a row, where every bond is counted via the neighbours in front.
+*/
+template<Form F, int D>
+inline double potential_row(const double* x, const double* const* rows, int extent, double osq, double lambda) noexcept {
+	const auto o = set1(osq);
+	const auto l = set1(2.0 * lambda);
+	const auto two = set1(2.0);
+	auto a = set1(0.0);
+	auto i = 0;
+
+	for (; i + width < extent; i += width) {
+		const auto xi = load(x + i);
+		auto nb = load(x + i + 1);
+
+		for (int k = D - 1; k < 2 * (D - 1); ++k)
+			nb = add(nb, load(rows[k] + i));
+
+		const auto c = F == Form::quartic ? fmadd(l, mul(xi, xi), o) : o;
+		a = fmadd(xi, fmsub(xi, c, mul(two, nb)), a);
+	}
+
+	auto sum = reduce(a);
+
+	for (; i < extent; ++i) {
+		auto nb = x[i == extent - 1 ? 0 : i + 1];
+
+		for (int k = D - 1; k < 2 * (D - 1); ++k)
+			nb += rows[k][i];
+
+		const auto c = F == Form::quartic ? osq + 2.0 * lambda * x[i] * x[i] : osq;
+		sum += x[i] * (x[i] * c - 2.0 * nb);
+	}
+
+	return sum;
+}
+
+template<int D>
+inline int volume(int extent) noexcept {
+	auto sites = extent;
+
+	for (int k = 1; k < D; ++k)
+		sites *= extent;
+
+	return sites;
+}
+
+template<Form F, int D>
+double kick_slices(double* p, const double* x, double osq, double lambda, double eps, int n, int first, int last) noexcept {
+	const double* rows[2 * (D - 1)];
+	auto sum = 0.0;
+
+	traverse<D>(n, first, last, [&](int offset, const int* neighbours) {
+		for (int k = 0; k < 2 * (D - 1); ++k)
+			rows[k] = x + neighbours[k];
+
+		sum += kick_row<F, D>(p + offset, x + offset, rows, n, osq, lambda, eps);
+	});
+
+	return sum;
+}
+
+template<Form F, int D>
+double potential_slices(const double* x, double osq, double lambda, int n, int first, int last) noexcept {
+	const double* rows[2 * (D - 1)];
+	auto sum = 0.0;
+
+	traverse<D>(n, first, last, [&](int offset, const int* neighbours) {
+		for (int k = 0; k < 2 * (D - 1); ++k)
+			rows[k] = x + neighbours[k];
+
+		sum += potential_row<F, D>(x + offset, rows, n, osq, lambda);
+	});
+
+	return sum;
+}
+
+template<Form F, int D>
+double kick_stencil(double* p, const double* x, double osq, double lambda, double eps, int n) noexcept {
+	return kick_slices<F, D>(p, x, osq, lambda, eps, n, 0, n);
+}
+
+template<Form F, int D>
+double potential_stencil(const double* x, double osq, double lambda, int n) noexcept {
+	return potential_slices<F, D>(x, osq, lambda, n, 0, n);
+}
+
+/**
+* Drifts all sites and kicks the momenta afterwards, as the stencil of the kick needs the drifted
+* neighbours in all dimensions.
+*/
+template<Form F, int D>
+double sweep_stencil(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n) noexcept {
+	drift_sites(y, x, v, ex, volume<D>(n));
+	return kick_stencil<F, D>(p, y, osq, lambda, ep, n);
+}
+
+template<Form F, int D>
+double sweep_potential_stencil(double* x, const double* v, double ex, double osq, double lambda, int n) noexcept {
+	drift_sites(x, x, v, ex, volume<D>(n));
+	return potential_stencil<F, D>(x, osq, lambda, n);
+}
+
+/**
+* Drifts the slices [first, last) of the last dimension and kicks the momenta of the slices in between.
+*/
+template<Form F, int D>
+double sweep_stencil_slices(double* y, const double* x, const double* v, double* p, double ex, double ep, double osq, double lambda, int n, int first, int last) noexcept {
+	const auto offset = first * volume<D - 1>(n);
+	drift_sites(y + offset, x + offset, v + offset, ex, (last - first) * volume<D - 1>(n));
+	return last - first > 2 ? kick_slices<F, D>(p, y, osq, lambda, ep, n, first + 1, last - 1) : 0.0;
+}
+
+template<Form F, int D>
+double sweep_potential_stencil_slices(double* x, const double* v, double ex, double osq, double lambda, int n, int first, int last) noexcept {
+	const auto offset = first * volume<D - 1>(n);
+	drift_sites(x + offset, x + offset, v + offset, ex, (last - first) * volume<D - 1>(n));
+	return last - first > 2 ? potential_slices<F, D>(x, osq, lambda, n, first + 1, last - 1) : 0.0;
+}
+
+template<Form F, int D>
+Specialization stencil() noexcept {
+	return Specialization {
+		&sweep_stencil<F, D>, &sweep_potential_stencil<F, D>, &kick_stencil<F, D>, &potential_stencil<F, D>,
+		&sweep_stencil_slices<F, D>, &sweep_potential_stencil_slices<F, D>, &kick_slices<F, D>, &potential_slices<F, D>, F, 0
+	};
+}
+
+/**
+* Selects the tiled stencils for a lattice with more than one dimension.
+*/
+template<Form F>
+Specialization stencil(int dimensions) noexcept {
+	switch (dimensions) {
+		case 2:
+			return stencil<F, 2>();
+		case 3:
+			return stencil<F, 3>();
+		default:
+			return stencil<F, 4>();
+	}
+}
+
+double* physics::kernels::allocate(int n, bool clear) noexcept {
+	const auto bytes = sizeof(double) * (n + 2 * halo);
+#ifdef _WIN32
+	auto base = static_cast<double*>(_aligned_malloc(bytes, alignment));
+#else
+	void* memory = nullptr;
+
+	if (posix_memalign(&memory, alignment, bytes) != 0)
+		memory = nullptr;
+
+	auto base = static_cast<double*>(memory);
+#endif
+
+	if (base == nullptr)
+		std::abort();
+
+	if (clear)
+		std::memset(base, 0, bytes);
+
+	return base + halo;
+}
+
+void physics::kernels::release(double* sites) noexcept {
+	if (sites == nullptr)
+		return;
+
+#ifdef _WIN32
+	_aligned_free(sites - halo);
+#else
+	std::free(sites - halo);
+#endif
+}
+
+const char* physics::kernels::instruction_set() noexcept {
+	return simd_name;
+}
+
+physics::kernels::Specialization physics::kernels::specialize(int n, double lambda, int dimensions) noexcept {
+	if (dimensions > 1)
+		return lambda == 0.0 ? stencil<Form::harmonic>(dimensions) : stencil<Form::quartic>(dimensions);
+
+	if (lambda == 0.0)
+		return specialization<Form::harmonic>(n);
+
+	return specialization<Form::quartic>(n);
+}
+
+void physics::kernels::drift(double* y, const double* x, const double* p, double eps, int n) noexcept {
+	drift_sites(y, x, p, eps, n);
+}
+
+double physics::kernels::kick(double* p, const double* x, double osq, double lambda, double eps, int n, int stride) noexcept {
+	if (lambda == 0.0)
+		return kick_sites<Form::harmonic>(p, x, osq, lambda, eps, n, stride);
+
+	return kick_sites<Form::quartic>(p, x, osq, lambda, eps, n, stride);
+}
+
+double physics::kernels::kick_anharmonic(double* p, const double* x, double lambda, double eps, int n) noexcept {
+	const auto m = vector_sites(n);
+	const auto c = eps * 4.0 * lambda;
+	const auto e = set1(c);
+	auto a = set1(0.0);
+
+	for (int i = 0; i < m; i += width) {
+		const auto xi = load(x + i);
+		const auto pi = fnmadd(e, mul(xi, mul(xi, xi)), load(p + i));
+		store(p + i, pi);
+		a = fmadd(pi, pi, a);
+	}
+
+	auto sum = reduce(a);
+
+	for (int i = m; i < n; ++i) {
+		p[i] -= c * (x[i] * (x[i] * x[i]));
+		sum += p[i] * p[i];
+	}
+
+	return sum;
+}
+
+double physics::kernels::kinetic(const double* p, int n) noexcept {
+	const auto m = vector_sites(n);
+	auto a = set1(0.0);
+	auto b = set1(0.0);
+	auto i = 0;
+
+	for (; i + width < m; i += 2 * width) {
+		const auto p0 = load(p + i);
+		const auto p1 = load(p + i + width);
+		a = fmadd(p0, p0, a);
+		b = fmadd(p1, p1, b);
+	}
+
+	for (; i < m; i += width) {
+		const auto p0 = load(p + i);
+		a = fmadd(p0, p0, a);
+	}
+
+	auto sum = reduce(add(a, b));
+
+	for (i = m; i < n; ++i)
+		sum += p[i] * p[i];
+
+	return sum;
+}
+
+double physics::kernels::potential(const double* x, double osq, double lambda, int n) noexcept {
+	if (lambda == 0.0)
+		return potential_sites<Form::harmonic>(x, osq, lambda, n);
+
+	return potential_sites<Form::quartic>(x, osq, lambda, n);
+}
+
+double physics::kernels::sum(const double* x, int n) noexcept {
+	const auto m = vector_sites(n);
+	auto a = set1(0.0);
+	auto b = set1(0.0);
+	auto i = 0;
+
+	for (; i + width < m; i += 2 * width) {
+		a = add(a, load(x + i));
+		b = add(b, load(x + i + width));
+	}
+
+	for (; i < m; i += width)
+		a = add(a, load(x + i));
+
+	auto result = reduce(add(a, b));
+
+	for (i = m; i < n; ++i)
+		result += x[i];
+
+	return result;
+}
+
+double physics::kernels::sum_square(const double* x, int n) noexcept {
+	return kinetic(x, n);
+}
@@ -18,131 +18,552 @@
 */
 
 #include "lattice.h"
+#include "kernels.h"
 #include <cmath>
+#include <cstring>
+#include <utility>
+#include <algorithm>
 
 inline int periodic(int index, int volume) noexcept {
 	return index < 0 ? (index + volume) : (index >= volume ? index - volume : index);
 }
 
-physics::Lattice::Lattice(std::mt19937& rng, int nt, int nstep, double tau, double omegasq, double lambda) noexcept :
-	rng(rng),
-	gauss(),
+/**
+* Limits the number of domains, such that every domain has at least two slices of the last dimension,
+* where a single dimension uses multiples of a cache line.
+*/
+inline int decompose(int domains, int nt, int dimensions, bool accelerated) noexcept {
+	const auto granularity = dimensions == 1 ? physics::kernels::halo : 1;
+	const auto most = nt / (2 * granularity);
+
+	if (accelerated || domains < 1 || most < 1)
+		return 1;
+
+	return std::min(domains, most);
+}
+
+int physics::Lattice::sites(int nt, int dimensions) noexcept {
+	auto volume = nt;
+
+	for (int k = 1; k < dimensions; ++k)
+		volume *= nt;
+
+	return volume;
+}
+
+physics::Lattice::Lattice(std::mt19937& rng, int nt, const Integrator& integrator, double omegasq, double lambda, bool accelerated, int dimensions, int domains) noexcept :
+	normals(rng),
+	philox(),
+	counter(false),
+	trajectory(0),
 	nt(nt),
-	nstep(nstep),
-	osq(2.0 + omegasq),
+	dimensions(dimensions > 1 ? dimensions : 1),
+	volume(sites(nt, this->dimensions)),
+	domain_count(decompose(domains, nt, this->dimensions, accelerated)),
+	slice(volume / nt),
+	integrator(integrator),
+	osq(2.0 * this->dimensions + omegasq),
 	lambda(lambda),
-	eps(tau / static_cast<double>(nstep)),
-	xv(new double[nt]),
-	xbck(new double[nt]),
-	pv(new double[nt]) {
-	const auto factor = 1.0 / sqrt(2.0 * omegasq);
+	kernel(kernels::specialize(nt, lambda, this->dimensions)),
+	harmonic_kernel(kernels::specialize(nt, 0.0, this->dimensions)),
+	xv(kernels::allocate(volume, domain_count == 1)),
+	xbck(kernels::allocate(volume, domain_count == 1)),
+	xtmp(kernels::allocate(volume, domain_count == 1)),
+	pv(kernels::allocate(volume, domain_count == 1)),
+	vv(accelerated && this->dimensions == 1 ? kernels::allocate(volume) : pv),
+	acceleration(accelerated && this->dimensions == 1 ? new Acceleration(nt, omegasq) : nullptr),
+	team(domain_count > 1 ? new concurrency::Team(domain_count, true) : nullptr),
+	bounds(),
+	partials(kernels::halo * domain_count),
+	kinetic(0.0),
+	potential(0.0),
+	backup(0.0),
+	kinetic_valid(false),
+	potential_valid(false),
+	velocity_valid(false),
+	pending(false),
+	swapped(false) {
+	const auto factor = omegasq > 0.0 ? 1.0 / sqrt(2.0 * omegasq) : 1.0;
+	const auto granularity = this->dimensions == 1 ? kernels::halo : 1;
+
+	for (int rank = 0; rank <= domain_count; ++rank)
+		bounds.push_back(rank == domain_count ? nt : static_cast<int>(static_cast<long long>(nt) * rank / domain_count) / granularity * granularity);
+
+	// Every member touches its domain first, such that the pages are placed on its NUMA node.
+	if (team) {
+		team->run([this](int rank) {
+			const auto first = bounds[rank] * slice;
+			const auto last = bounds[rank + 1] * slice;
+
+			for (auto sites : { xv, xbck, xtmp, pv }) {
+				std::memset(sites + first, 0, sizeof(double) * (last - first));
+
+				if (rank == 0)
+					std::memset(sites - kernels::halo, 0, sizeof(double) * kernels::halo);
+
+				if (rank == domain_count - 1)
+					std::memset(sites + volume, 0, sizeof(double) * kernels::halo);
+			}
+		});
+	}
+
+	normals(xv, volume);
 
-	for(int i = 0; i < nt; ++i)
-		xv[i] = gauss(rng) * factor;
+	for(int i = 0; i < volume; ++i)
+		xv[i] *= factor;
 }
 
 physics::Lattice::~Lattice() noexcept {
-	delete[] xv;
-	delete[] xbck;
-	delete[] pv;
+	kernels::release(xv);
+	kernels::release(xbck);
+	kernels::release(xtmp);
+	kernels::release(pv);
+
+	if (vv != pv)
+		kernels::release(vv);
 }
 
 double physics::Lattice::x(int index) const noexcept {
-	return xv[periodic(index, nt)];
+	return xv[periodic(index, volume)];
 }
 
 double physics::Lattice::p(int index) const noexcept {
-	return pv[periodic(index, nt)];
+	return pv[periodic(index, volume)];
 }
 
 void physics::Lattice::x(int index, double value) noexcept {
-	xv[periodic(index, nt)] = value;
+	xv[periodic(index, volume)] = value;
+	potential_valid = false;
+	pending = false;
+	swapped = false;
 }
 
 void physics::Lattice::p(int index, double value) noexcept {
-	pv[periodic(index, nt)] = value;
+	pv[periodic(index, volume)] = value;
+	kinetic_valid = false;
+	velocity_valid = false;
 }
 
 void physics::Lattice::store() noexcept {
-	for (int i = 0; i < nt; ++i)
-		xbck[i] = xv[i];
+	pending = true;
+	swapped = false;
 }
 
 void physics::Lattice::restore() noexcept {
-	for (int i = 0; i < nt; ++i)
-		xv[i] = xbck[i];
+	if (swapped) {
+		std::swap(xv, xbck);
+		potential = backup;
+		potential_valid = true;
+	}
+
+	pending = false;
+	swapped = false;
+}
+
+void physics::Lattice::generator(const numerics::Philox& philox) noexcept {
+	this->philox = philox;
+	counter = true;
+}
+
+int physics::Lattice::domains() const noexcept {
+	return domain_count;
+}
+
+std::size_t physics::Lattice::footprint() const noexcept {
+	const auto arrays = vv != pv ? 5 : 4;
+	return arrays * sizeof(double) * (static_cast<std::size_t>(volume) + 2 * kernels::halo);
 }
 
 void physics::Lattice::randomize() noexcept {
-	for (int i = 0; i < nt; ++i)
-		pv[i] = gauss(rng);
+	if (team) {
+		const auto current = trajectory;
+
+		if (counter)
+			++trajectory;
+		else
+			normals(pv, volume);
+
+		// The counter-based momenta of a domain are drawn by its owner.
+		kinetic = reduce([this, current](int rank) {
+			const auto first = site(rank);
+			const auto n = site(rank + 1) - first;
+
+			if (counter)
+				philox.gaussians(pv + first, n, current, first);
+
+			return kernels::kinetic(pv + first, n);
+		});
+
+		kinetic_valid = true;
+		return;
+	}
+
+	if (counter)
+		philox.gaussians(pv, volume, trajectory++);
+	else
+		normals(pv, volume);
+
+	kinetic = kernels::kinetic(pv, volume);
+	kinetic_valid = true;
+
+	if (acceleration) {
+		acceleration->momenta(pv, pv);
+		kinetic = acceleration->velocities(pv, vv);
+		velocity_valid = true;
+	}
+}
+
+void physics::Lattice::refresh() const noexcept {
+	refresh(xv);
+}
+
+void physics::Lattice::refresh(double* sites) const noexcept {
+	// The stencils of more than one dimension wrap around on their own.
+	if (dimensions == 1) {
+		sites[-1] = sites[nt - 1];
+		sites[nt] = sites[0];
+	}
+}
+
+void physics::Lattice::refresh(double* sites, int first, int last) const noexcept {
+	if (dimensions == 1) {
+		if (first == 0)
+			sites[nt] = sites[0];
+
+		if (last == nt)
+			sites[-1] = sites[nt - 1];
+	}
 }
 
 double physics::Lattice::force(int n) const noexcept {
-	return osq * x(n) - x(n - 1) - x(n + 1) + 4.0 * lambda * pow(x(n), 3);
+	const auto site = periodic(n, volume);
+	const auto xn = xv[site];
+	auto neighbours = 0.0;
+
+	for (int k = 0, stride = 1; k < dimensions; ++k, stride *= nt) {
+		const auto c = (site / stride) % nt;
+		neighbours += xv[c == 0 ? site + (nt - 1) * stride : site - stride];
+		neighbours += xv[c == nt - 1 ? site - (nt - 1) * stride : site + stride];
+	}
+
+	return osq * xn - neighbours + 4.0 * lambda * xn * xn * xn;
 }
 
-void physics::Lattice::integrate_x(double eps) noexcept {
-	for (int i = 0; i < nt; ++i)
-		xv[i] += eps * pv[i];
+double physics::Lattice::sweep(double* y, double ex, double ep, double coupling) noexcept {
+	const auto& specialized = coupling == 0.0 ? harmonic_kernel : kernel;
+	return specialized.sweep(y, xv, vv, pv, ex, ep, osq, coupling, nt);
 }
 
-void physics::Lattice::integrate_p(double eps) noexcept {
-	for (int i = 0; i < nt; ++i)
-		pv[i] -= eps * force(i);
+double physics::Lattice::sweep_potential(double ex) noexcept {
+	return kernel.sweep_potential(xv, vv, ex, osq, lambda, nt);
 }
 
-void physics::Lattice::integrate() noexcept {
-	integrate_x(eps * 0.5);
-	integrate_p(eps);
+double physics::Lattice::apply(double* y, const double* x, Force force, double eps) const noexcept {
+	switch (force) {
+		case Force::harmonic:
+			return harmonic_kernel.kick(y, x, osq, 0.0, eps, nt);
+		case Force::anharmonic:
+			return kernels::kick_anharmonic(y, x, lambda, eps, volume);
+		default:
+			return kernel.kick(y, x, osq, lambda, eps, nt);
+	}
+}
 
-	for (int i = 1; i < nstep; ++i) {
-		integrate_x(eps);
-		integrate_p(eps);
+double physics::Lattice::kick(const Operation& op) noexcept {
+	refresh();
+
+	if (op.gradient == 0.0)
+		return apply(pv, xv, op.force, op.coefficient);
+
+	if (acceleration) {
+		// The shift follows the velocities of the force, x - g M⁻¹ F, so the velocities serve as scratch.
+		std::fill(vv, vv + volume, 0.0);
+		apply(vv, xv, op.force, op.gradient);
+		acceleration->velocities(vv, vv);
+		kernels::drift(xtmp, xv, vv, 1.0, volume);
+	} else {
+		std::memcpy(xtmp, xv, sizeof(double) * volume);
+		apply(xtmp, xv, op.force, op.gradient);
 	}
 
-	integrate_x(eps * 0.5);
+	refresh(xtmp);
+	return apply(pv, xtmp, op.force, op.coefficient);
 }
 
-double physics::Lattice::hamilton() const noexcept {
-	using std::pow;
-	auto sum = 0.0;
+double physics::Lattice::apply(double* y, const double* x, Force force, double eps, int first, int last) const noexcept {
+	switch (force) {
+		case Force::harmonic:
+			return harmonic_kernel.kick_slices(y, x, osq, 0.0, eps, nt, first, last);
+		case Force::anharmonic:
+			return kernels::kick_anharmonic(y + first * slice, x + first * slice, lambda, eps, (last - first) * slice);
+		default:
+			return kernel.kick_slices(y, x, osq, lambda, eps, nt, first, last);
+	}
+}
 
-	for(int i = 0; i < nt; ++i) {
-		sum += pow(p(i), 2);
-		sum += osq * pow(x(i), 2) + 2.0 * lambda * pow(x(i), 4);
-		sum -= x(i) * (x(i - 1) + x(i + 1));
+double physics::Lattice::kick(const Operation& op, const double* x, int first, int last) noexcept {
+	if (op.gradient == 0.0)
+		return apply(pv, x, op.force, op.coefficient, first, last);
+
+	const auto offset = first * slice;
+	std::memcpy(xtmp + offset, x + offset, sizeof(double) * (last - first) * slice);
+	apply(xtmp, x, op.force, op.gradient, first, last);
+	refresh(xtmp, first, last);
+	team->barrier();
+	return apply(pv, xtmp, op.force, op.coefficient, first, last);
+}
+
+void physics::Lattice::integrate_domains() noexcept {
+	const auto& ops = integrator.operations();
+	const auto count = ops.size();
+	auto computed = false;
+
+	if (pending)
+		backup = potential_energy();
+
+	refresh();
+
+	// A sweep drifts the domain and kicks its inner slices, the boundary slices are kicked after the
+	// neighbouring domains have drifted. A barrier after every operation protects the boundary sites.
+	team->run([this, &ops, count, &computed](int rank) {
+		const auto first = bounds[rank];
+		const auto last = bounds[rank + 1];
+		const auto partial = &partials[rank * kernels::halo];
+		const double* x = xv;
+		const auto target = pending ? xbck : xv;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			const auto& op = ops[i];
+
+			if (!op.drift) {
+				partial[0] = kick(op, x, first, last);
+
+				if (i + 1 < count)
+					team->barrier();
+
+				continue;
+			}
+
+			const auto next = i + 1 < count ? &ops[i + 1] : nullptr;
+
+			if (next && !next->drift && next->gradient == 0.0 && next->force != Force::anharmonic) {
+				const auto coupling = next->force == Force::full ? lambda : 0.0;
+				const auto& specialized = coupling == 0.0 ? harmonic_kernel : kernel;
+				auto sum = specialized.sweep_slices(target, x, vv, pv, op.coefficient, next->coefficient, osq, coupling, nt, first, last);
+				team->barrier();
+				sum += specialized.kick_slices(pv, target, osq, coupling, next->coefficient, nt, first, first + 1);
+				partial[0] = sum + specialized.kick_slices(pv, target, osq, coupling, next->coefficient, nt, last - 1, last);
+				++i;
+			} else if (!next && x == target) {
+				auto sum = kernel.sweep_potential_slices(target, vv, op.coefficient, osq, lambda, nt, first, last);
+				team->barrier();
+				sum += kernel.potential_slices(target, osq, lambda, nt, first, first + 1);
+				partial[1] = sum + kernel.potential_slices(target, osq, lambda, nt, last - 1, last);
+
+				if (rank == 0)
+					computed = true;
+			} else {
+				kernels::drift(target + first * slice, x + first * slice, vv + first * slice, op.coefficient, (last - first) * slice);
+				refresh(target, first, last);
+			}
+
+			x = target;
+
+			if (i + 1 < count)
+				team->barrier();
+		}
+	});
+
+	if (pending) {
+		std::swap(xv, xbck);
+		pending = false;
+		swapped = true;
 	}
 
-	return 0.5 * sum;
+	if (computed)
+		potential = combine(0, domain_count, 1);
+
+	kinetic = combine(0, domain_count, 0);
+	kinetic_valid = true;
+	potential_valid = computed;
 }
 
-double physics::Lattice::x_average() const noexcept {
-	auto sum = 0.0;
+double physics::Lattice::reduce(const std::function<double(int)>& part) const noexcept {
+	team->run([this, &part](int rank) {
+		partials[rank * kernels::halo] = part(rank);
+	});
+
+	return combine(0, domain_count, 0);
+}
 
-	for (int i = 0; i < nt; ++i)
-		sum += xv[i];
+double physics::Lattice::combine(int first, int last, int slot) const noexcept {
+	if (last - first == 1)
+		return partials[first * kernels::halo + slot];
 
-	return sum / static_cast<double>(nt);
+	const auto middle = first + (last - first) / 2;
+	return combine(first, middle, slot) + combine(middle, last, slot);
 }
 
-double physics::Lattice::x_square_average() const noexcept {
-	auto sum = 0.0;
+int physics::Lattice::site(int rank) const noexcept {
+	return rank == domain_count ? volume : bounds[rank] * slice / 2 * 2;
+}
 
-	for (int i = 0; i < nt; ++i)
-		sum += xv[i] * xv[i];
+void physics::Lattice::integrate() noexcept {
+	if (team) {
+		integrate_domains();
+		return;
+	}
 
-	return sum / static_cast<double>(nt);
+	const auto& ops = integrator.operations();
+	const auto count = ops.size();
+	auto computed = false;
+
+	if (pending)
+		backup = potential_energy();
+
+	for (std::size_t i = 0; i < count; ++i) {
+		const auto& op = ops[i];
+
+		if (!op.drift) {
+			kinetic = kick(op);
+			velocity_valid = false;
+			continue;
+		}
+
+		if (acceleration && !velocity_valid) {
+			kinetic = acceleration->velocities(pv, vv);
+			velocity_valid = true;
+		}
+
+		const auto next = i + 1 < count ? &ops[i + 1] : nullptr;
+		const auto target = pending ? xbck : xv;
+
+		// A drift is fused with a following plain kick, the final drift computes the action.
+		if (next && !next->drift && next->gradient == 0.0 && next->force != Force::anharmonic) {
+			kinetic = sweep(target, op.coefficient, next->coefficient, next->force == Force::full ? lambda : 0.0);
+			velocity_valid = false;
+			++i;
+		} else if (!next && !pending) {
+			potential = sweep_potential(op.coefficient);
+			computed = true;
+		} else
+			kernels::drift(target, xv, vv, op.coefficient, volume);
+
+		if (pending) {
+			std::swap(xv, xbck);
+			pending = false;
+			swapped = true;
+		}
+	}
+
+	kinetic_valid = !acceleration || velocity_valid;
+	potential_valid = computed;
 }
 
-double physics::Lattice::action_average() const noexcept {
-	using std::pow;
-	auto sum = 0.0;
+int physics::Lattice::steps() const noexcept {
+	return integrator.steps();
+}
+
+double physics::Lattice::step_size() const noexcept {
+	return integrator.step_size();
+}
+
+void physics::Lattice::step_size(double eps) noexcept {
+	const auto steps = std::ceil(integrator.trajectory_length() / eps);
+	integrator = integrator.resize(steps < 1.0 ? 1 : (steps > Integrator::max_steps ? Integrator::max_steps : static_cast<int>(steps)));
+}
+
+void physics::Lattice::save(io::Checkpoint& checkpoint) const noexcept {
+	// The cached action is kept, as a recomputation would sum up the sites in a different order.
+	checkpoint.put(integrator.steps());
+	checkpoint.put(xv, volume);
+	checkpoint.put(potential_energy());
+	checkpoint.put_state(normals);
+	checkpoint.put(trajectory);
+}
+
+void physics::Lattice::load(io::Checkpoint& checkpoint) {
+	const auto steps = checkpoint.get<int>();
+	checkpoint.get(xv, volume);
+	potential = checkpoint.get<double>();
+	checkpoint.get_state(normals);
+	trajectory = checkpoint.get<std::uint64_t>();
+	integrator = integrator.resize(steps);
+	potential_valid = true;
+	kinetic_valid = false;
+	velocity_valid = false;
+	pending = false;
+	swapped = false;
+}
 
-	for (int i = 0; i < nt; ++i) {
-		sum += osq * pow(x(i), 2) + 2.0 * lambda * pow(x(i), 4);
-		sum -= x(i) * (x(i - 1) + x(i + 1));
+double physics::Lattice::potential_energy() const noexcept {
+	if (!potential_valid) {
+		refresh();
+		potential = team ? reduce([this](int rank) {
+			return kernel.potential_slices(xv, osq, lambda, nt, bounds[rank], bounds[rank + 1]);
+		}) : kernel.potential(xv, osq, lambda, nt);
+		potential_valid = true;
 	}
 
-	return 0.5 * sum / static_cast<double>(nt);
+	return potential;
+}
+
+double physics::Lattice::hamilton() const noexcept {
+	if (!kinetic_valid) {
+		if (acceleration) {
+			kinetic = acceleration->velocities(pv, vv);
+			velocity_valid = true;
+		} else if (team) {
+			kinetic = reduce([this](int rank) {
+				return kernels::kinetic(pv + site(rank), site(rank + 1) - site(rank));
+			});
+		} else
+			kinetic = kernels::kinetic(pv, volume);
+
+		kinetic_valid = true;
+	}
+
+	return 0.5 * (kinetic + potential_energy());
+}
+
+double physics::Lattice::action(const physics::Lattice& other) const noexcept {
+	if (&other == this)
+		return 0.5 * potential_energy();
+
+	other.refresh();
+	return 0.5 * kernel.potential(other.xv, osq, lambda, nt);
+}
+
+void physics::Lattice::exchange(physics::Lattice& other) noexcept {
+	std::swap(xv, other.xv);
+	potential_valid = false;
+	pending = false;
+	swapped = false;
+	other.potential_valid = false;
+	other.pending = false;
+	other.swapped = false;
+}
+
+double physics::Lattice::x_average() const noexcept {
+	if (team) {
+		return reduce([this](int rank) {
+			return kernels::sum(xv + site(rank), site(rank + 1) - site(rank));
+		}) / static_cast<double>(volume);
+	}
+
+	return kernels::sum(xv, volume) / static_cast<double>(volume);
+}
+
+double physics::Lattice::x_square_average() const noexcept {
+	if (team) {
+		return reduce([this](int rank) {
+			return kernels::sum_square(xv + site(rank), site(rank + 1) - site(rank));
+		}) / static_cast<double>(volume);
+	}
+
+	return kernels::sum_square(xv, volume) / static_cast<double>(volume);
+}
+
+double physics::Lattice::action_average() const noexcept {
+	return 0.5 * potential_energy() / static_cast<double>(volume);
 }
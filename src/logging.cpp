@@ -0,0 +1,79 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "logging.h"
+
+diagnostics::Progress::Progress(Logger& logger, const std::string& name, int total) noexcept :
+	logger(logger),
+	name(name),
+	total(total),
+	done(0),
+	count(0),
+	accepted(0),
+	xs(0.0),
+	xsqs(0.0),
+	active(logger.enabled(Level::info) && (logger.progress_every() > 0 || logger.progress_seconds() > 0.0)),
+	last(std::chrono::steady_clock::now()) {
+}
+
+void diagnostics::Progress::update(bool accepted, double x, double xsquare) noexcept {
+	using std::chrono::duration;
+	using std::chrono::steady_clock;
+
+	if (!active)
+		return;
+
+	++done;
+	++count;
+	this->accepted += accepted;
+	xs += x;
+	xsqs += xsquare;
+
+	const auto every = logger.progress_every();
+	const auto seconds = logger.progress_seconds();
+
+	if ((every > 0 && count >= every) || (seconds > 0.0 && duration<double>(steady_clock::now() - last).count() >= seconds))
+		summarize();
+}
+
+void diagnostics::Progress::finish() noexcept {
+	if (active && count > 0)
+		summarize();
+}
+
+void diagnostics::Progress::summarize() noexcept {
+	using std::chrono::duration;
+	using std::chrono::steady_clock;
+
+	const auto now = steady_clock::now();
+	const auto elapsed = duration<double>(now - last).count();
+	const auto n = static_cast<double>(count);
+
+	logger.info(name, " [", done, "/", total, "] ",
+		"acc = ", accepted / n, ", ",
+		"<x> = ", xs / n, ", ",
+		"<x²> = ", xsqs / n, ", ",
+		n / elapsed, " traj/s");
+
+	last = now;
+	count = 0;
+	accepted = 0;
+	xs = 0.0;
+	xsqs = 0.0;
+}
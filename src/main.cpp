@@ -19,29 +19,91 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <iomanip>
+#include <memory>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <random>
+#include <limits>
 #include "cmdparser.h"
 #include "configuration.h"
 #include "harmonic.h"
-#include "autocorrelation.h"
+#include "ensemble.h"
+#include "sweep.h"
+#include "tempering.h"
+#include "multilevel.h"
+#include "streaming.h"
+#include "resampling.h"
+#include "threadpool.h"
+#include "history.h"
+#include "logging.h"
+#include "checkpoint.h"
+#include "profiling.h"
 
 using namespace std;
 using namespace physics;
 using namespace statistics;
+using namespace io;
+using namespace diagnostics;
+
+/**
+* The maximum number of events of a trace, i.e. about 24 MB.
+*/
+const size_t trace_capacity = 1 << 20;
+
+/**
+* The primary observables of a measurement for the resampling analysis.
+*/
+namespace primary {
+	enum : int {
+		acceptance = 0,
+		x = 1,
+		x_square = 2,
+		action = 3,
+		mean_square = 4,
+		mean_quartic = 5,
+		count = 6
+	};
+}
 
 void setup(CmdParser& parser) {
 	parser.set_optional<string>("o", "output", "data.out", "Name of the file that will be used for output.");
+	parser.set_optional<string>("f", "format", "text", "The format of the output file, either text or binary.");
 	parser.set_optional<int>("n", "nt", 100, "The number of points in temporal direction.");
+	parser.set_optional<int>("d", "dimensions", 1, "The number of dimensions of the lattice, at most 4, each with Nt points.");
+	parser.set_optional<int>("e", "domains", 1, "The number of domains of a single lattice, each integrated by its own pinned thread.");
 	parser.set_optional<double>("w", "omegasq", 1.0, "The value of the coupling ω². It is ω ~ a.");
 	parser.set_optional<double>("l", "lambda", 0.0, "The parameter of the anharmonic term λ.");
 	parser.set_optional<double>("t", "tau", 1.0, "The trajectory length in molecular dynamics time, where ε = τ / nsteps.");
-	parser.set_optional<int>("r", "nsteps", 10, "The number of leapfrog steps per trajectory.");
+	parser.set_optional<int>("r", "nsteps", 10, "The number of integration steps per trajectory.");
+	parser.set_optional<string>("I", "integrator", "leapfrog", "The integrator, either leapfrog, omelyan2, omelyan4 or fg (force-gradient).");
+	parser.set_optional<double>("L", "omelyan", Integrator::default_parameter, "The tuning parameter λ of the omelyan2 integrator.");
+	parser.set_optional<int>("R", "substeps", 0, "The number of inner steps of the anharmonic force per update of the sites, 0 disables splitting.");
+	parser.set_optional<bool>("F", "fourier", false, "Uses a kinetic mass in momentum space, such that all modes move at comparable speed.");
+	parser.set_optional<double>("a", "adapt", 0.0, "The target acceptance rate for adapting the step size during the thermalization, 0 to keep nsteps.");
+	parser.set_optional<string>("G", "rng", "mt19937", "The random number engine, either mt19937 or the counter-based philox.");
+	parser.set_optional<int>("C", "checkpoint", 0, "The number of measurements between two checkpoints in <output>.checkpoint, 0 to disable.");
+	parser.set_optional<bool>("x", "resume", false, "Continues the run from the checkpoint in <output>.checkpoint.");
 	parser.set_optional<int>("m", "nmeas", 1000, "The number of steps, i.e. the number of measurements.");
 	parser.set_optional<int>("i", "ninit", 100, "The number of steps in the thermalization process.");
 	parser.set_optional<int>("s", "seed", 0, "The seed for the random number generator.");
 	parser.set_optional<bool>("@", "noconsole", false, "Deactivates terminal output during measurements.");
+	parser.set_optional<bool>("v", "verbose", false, "Writes the details of every single trajectory to the terminal.");
+	parser.set_optional<int>("p", "progress", 0, "The number of trajectories between two progress summaries, 0 to disable.");
+	parser.set_optional<double>("P", "interval", 10.0, "The number of seconds between two progress summaries, 0 to disable.");
+	parser.set_optional<int>("B", "replicas", 1000, "The number of bootstrap replicas of the resampling analysis, below 2 disables the bootstrap.");
+	parser.set_optional<int>("W", "window", 1000, "The maximum lag that is tracked for the autocorrelation analysis, at least 1.");
+	parser.set_optional<int>("c", "chains", 1, "The number of independent Markov chains, each writing to <output>.<chain>.");
+	parser.set_optional<int>("j", "threads", 0, "The number of threads for running the chains or the resampling, 0 uses all cores.");
+	parser.set_optional<int>("k", "batch", 1, "The number of chains that are evolved together in lock-step on a single core.");
+	parser.set_optional<string>("T", "tempering", "", "The couplings of the replicas of a replica exchange, e.g. \"lambda=0:2:0.25\".");
+	parser.set_optional<int>("X", "exchange", 1, "The number of trajectories between two exchanges of neighbouring replicas.");
+	parser.set_optional<int>("M", "multilevel", 0, "The number of sites per slab of the multilevel correlator, 0 to disable.");
+	parser.set_optional<int>("U", "updates", 10, "The number of updates of the slabs per trajectory of the multilevel scheme.");
+	parser.set_optional<int>("D", "distance", 0, "The maximum distance of the multilevel correlator, 0 uses Nt / 2.");
+	parser.set_optional<string>("Z", "trace", "", "The Chrome trace file of the timed phases, which requires a build with PROFILE.");
+	parser.set_optional<string>("S", "sweep", "", "The grid of a parameter sweep, e.g. \"omegasq=0.5,1 seed=0:3\", or a file with one grid per line.");
 }
 
 void parse_and_exit(CmdParser& parser) {
@@ -53,7 +115,7 @@ double compute_analytic(const Configuration& cfg) {
 	using std::sqrt;
 	using std::pow;
 
-	if (cfg.lambda != 0.0)
+	if (cfg.lambda != 0.0 || cfg.dimensions > 1)
 		return nan("");
 
 	const auto nt = cfg.nt;
@@ -67,27 +129,401 @@ double compute_analytic(const Configuration& cfg) {
 	return a / b;
 }
 
-void print_result(const Observable<double>& tau, double analytic_result, const Harmonic& sim) {
+void primaries(const Measurement& measurement, double* values) {
+	const auto square = measurement.x * measurement.x;
+	values[primary::acceptance] = measurement.accepted ? 1.0 : 0.0;
+	values[primary::x] = measurement.x;
+	values[primary::x_square] = measurement.x_square;
+	values[primary::action] = measurement.action;
+	values[primary::mean_square] = square;
+	values[primary::mean_quartic] = square * square;
+}
+
+/**
+* Gets the observables of the resampling analysis with their labels. The derived observables are the variance of
+* the sites, the susceptibility of the average, the Binder ratio and, for the harmonic chain, the virial energy.
+*/
+vector<pair<string, Resampling::Estimator>> estimators(const Configuration& cfg) {
+	const auto sites = static_cast<double>(Lattice::sites(cfg.nt, cfg.dimensions));
+	const auto omegasq = cfg.omega_square;
+	vector<pair<string, Resampling::Estimator>> result {
+		{ "acc ", [](const double* p) { return p[primary::acceptance]; } },
+		{ "<x> ", [](const double* p) { return p[primary::x]; } },
+		{ "<x²>", [](const double* p) { return p[primary::x_square]; } },
+		{ "<S> ", [](const double* p) { return p[primary::action]; } },
+		{ "σ²  ", [](const double* p) { return p[primary::x_square] - p[primary::x] * p[primary::x]; } },
+		{ "χ   ", [sites](const double* p) { return sites * (p[primary::mean_square] - p[primary::x] * p[primary::x]); } },
+		{ "U   ", [](const double* p) { return 1.0 - p[primary::mean_quartic] / (3.0 * p[primary::mean_square] * p[primary::mean_square]); } }
+	};
+
+	if (cfg.lambda == 0.0 && cfg.dimensions == 1)
+		result.emplace_back("E₀  ", [omegasq](const double* p) { return omegasq * p[primary::x_square]; });
+
+	return result;
+}
+
+vector<Estimate> analyze(const Resampling& samples, const vector<pair<string, Resampling::Estimator>>& observables, double tau, int replicas, int threads, int seed) {
+	vector<Resampling::Estimator> functions { };
+	concurrency::ThreadPool pool { threads };
+
+	for (const auto& observable : observables)
+		functions.push_back(observable.second);
+
+	return samples.compute(functions, tau, replicas, static_cast<uint32_t>(seed), pool);
+}
+
+/**
+* Checks if a configuration can be simulated.
+*
+* @param The configuration.
+* @param True if the chains are evolved in batches.
+* @param True if the multilevel scheme is used.
+* @return The reason why the configuration is rejected, or an empty string if it is valid.
+*/
+string check_configuration(const Configuration& cfg, bool batched, bool multilevel) {
+	if (cfg.nt < 2)
+		return "The lattice requires at least 2 sites per dimension.";
+
+	if (cfg.nmeas < 1 || cfg.nstep < 1 || cfg.ntherm < 0)
+		return "The simulation requires at least 1 measurement, at least 1 integration step and no negative number of thermalization steps.";
+
+	if (cfg.dimensions < 1 || cfg.dimensions > 4)
+		return "The lattice requires 1 to 4 dimensions.";
+
+	if (cfg.fourier && cfg.omega_square <= 0.0)
+		return "The Fourier acceleration requires ω² > 0, as its kinetic mass vanishes for the zero mode otherwise.";
+
+	if (cfg.dimensions > 1) {
+		if (pow(static_cast<double>(cfg.nt), cfg.dimensions) > numeric_limits<int>::max())
+			return "The lattice has too many sites.";
+
+		if (cfg.fourier || batched || multilevel)
+			return "The Fourier acceleration, batched chains and the multilevel scheme require a single dimension.";
+	}
+
+	return string { };
+}
+
+void print_result(const Observable<double>& tau, double analytic_result, const Harmonic& sim, const vector<pair<string, Resampling::Estimator>>& observables, const vector<Estimate>& estimates, size_t bin_size, int replicas) {
+	// The bootstrap is skipped for fewer than two replicas, which leaves only the error of the jackknife.
+	const auto bootstrap = replicas > 1;
+	cout << "Measurements statistics ..." << endl;
+	cout << "Nstep = " << sim.steps() << " (ε = " << sim.step_size() << ")" << endl;
+	cout << "Bin  = " << bin_size << (bootstrap ? " (errors of the jackknife and the bootstrap)" : " (error of the jackknife)") << endl;
+
+	for (size_t i = 0; i < estimates.size(); ++i) {
+		cout << observables[i].first << " = " << estimates[i].mean << " ± " << estimates[i].jackknife;
+
+		if (bootstrap)
+			cout << " ± " << estimates[i].bootstrap;
+
+		cout << endl;
+	}
+
+	cout << "x²a  = " << analytic_result << endl;
+	cout << "<τi> = " << tau.mean << endl;
+	cout << "στi  = " << tau.uncertainty << endl;
+}
+
+void print_result(const Ensemble& ensemble, double analytic_result) {
+	const auto acc = ensemble.compute_acceptance();
+	const auto xs = ensemble.compute_x();
+	const auto xsq = ensemble.compute_x_square();
+	const auto tau = ensemble.compute_tau();
+	auto fewest = Integrator::max_steps;
+	auto most = 0;
+
+	for (const auto& result : ensemble.results()) {
+		fewest = min(fewest, result.steps);
+		most = max(most, result.steps);
+	}
+
+	cout << "Measurements statistics ..." << endl;
+	cout << "Nstep = " << fewest;
+
+	if (most > fewest)
+		cout << " - " << most;
+
+	cout << endl;
+	cout << "acc  = " << acc.mean << " ± " << acc.uncertainty << endl;
+	cout << "<x>  = " << xs.mean << " ± " << xs.uncertainty << endl;
+	cout << "<x²> = " << xsq.mean << " ± " << xsq.uncertainty << endl;
+	cout << "x²a  = " << analytic_result << endl;
+	cout << "<τi> = " << tau.mean << endl;
+	cout << "στi  = " << tau.uncertainty << endl;
+}
+
+void print_profile(const string& trace, Logger& log) {
+#if PROFILE
+	Profiler::instance().summarize(cout);
+
+	if (trace.size() > 0 && !Profiler::instance().write_trace(trace))
+		log.warning("The trace ", trace, " could not be written.");
+#else
+	(void)trace;
+	(void)log;
+#endif
+}
+
+unique_ptr<HistoryWriter> create_and_check(const string& format, const string& name, const Configuration& config, uint64_t offset = 0) {
+	auto writer = create_writer(format, name, config, offset);
+
+	if (writer == nullptr) {
+		cerr << "The output format " << format << " is not supported." << endl;
+		exit(1);
+	}
+
+	return writer;
+}
+
+int run_chains(const Configuration& config, const string& format, const string& name, int chains, int threads, int batch, int window, Logger& log) {
+	vector<unique_ptr<HistoryWriter>> outputs { };
+	Ensemble ensemble { config, chains, threads, batch, window, log };
+
+	for (int chain = 0; chain < chains; ++chain) {
+		auto cfg = config;
+		cfg.seed = ensemble.seed(chain);
+		outputs.push_back(create_and_check(format, name + "." + to_string(chain), cfg));
+	}
+
+	cout << "Running " << chains << " chains ..." << endl;
+
+	const auto completed = ensemble.run([&outputs](int chain, const Measurement& measurement) {
+		outputs[chain]->write(measurement);
+	});
+
+	for (auto& output : outputs)
+		output->close();
+
+	if (!completed) {
+		log.error("The thermalization of a chain failed.");
+		return 1;
+	}
+
+	print_result(ensemble, compute_analytic(config));
+	return 0;
+}
+
+void print_summary(ostream& os, const Sweep& sweep) {
+	const auto& configurations = sweep.configurations();
+	const auto& results = sweep.results();
+	const auto& durations = sweep.durations();
+
+	os << "job\tNt\td\tω²\tλ\tτ\tNstep\tNmeas\tSeed\tacc\t<x>\t<x²>\tx²a\t<τi>\tστi\ttime" << endl;
+
+	for (size_t job = 0; job < results.size(); ++job) {
+		const auto& cfg = configurations[job];
+		const auto& result = results[job];
+
+		os << job << '\t' << cfg.nt << '\t' << cfg.dimensions << '\t' << cfg.omega_square << '\t' << cfg.lambda << '\t' << cfg.tau << '\t';
+		os << result.steps << '\t' << cfg.nmeas << '\t' << cfg.seed << '\t' << result.acceptance << '\t';
+		os << result.x << '\t' << result.x_square << '\t' << compute_analytic(cfg) << '\t';
+		os << result.tau.mean << '\t' << result.tau.uncertainty << '\t' << durations[job] << endl;
+	}
+}
+
+int run_sweep(const Configuration& config, const string& grid, const string& format, const string& name, int threads, int window, Logger& log) {
+	vector<Configuration> configurations { };
+	ifstream file { grid };
+	auto valid = true;
+
+	if (file.is_open()) {
+		string line { };
+
+		while (valid && getline(file, line)) {
+			if (line.size() > 0 && line[0] != '#')
+				valid = Sweep::expand(line, config, configurations);
+		}
+	} else
+		valid = Sweep::expand(grid, config, configurations);
+
+	if (!valid || configurations.empty()) {
+		log.error("The sweep ", grid, " could not be parsed.");
+		return 1;
+	}
+
+	for (size_t job = 0; job < configurations.size(); ++job) {
+		const auto reason = check_configuration(configurations[job], false, false);
+
+		if (reason.size() > 0) {
+			const auto& cfg = configurations[job];
+			log.error("The job ", job, " of the sweep ", grid, " (Nt = ", cfg.nt, ", d = ", cfg.dimensions, ", Nmeas = ", cfg.nmeas, ", Nterm = ", cfg.ntherm, ", Nstep = ", cfg.nstep, ") is invalid: ", reason);
+			return 1;
+		}
+	}
+
+	if (format != "text" && format != "binary") {
+		log.error("The output format ", format, " is not supported.");
+		return 1;
+	}
+
+	vector<unique_ptr<HistoryWriter>> outputs(configurations.size());
+	Sweep sweep { configurations, threads, window, log };
+
+	cout << "Running " << configurations.size() << " jobs ..." << endl;
+
+	const auto completed = sweep.run([&outputs, &configurations, &format, &name](int job) {
+		outputs[job] = create_writer(format, name + "." + to_string(job), configurations[job]);
+	}, [&outputs](int job, const Measurement& measurement) {
+		outputs[job]->write(measurement);
+	}, [&outputs](int job) {
+		outputs[job]->close();
+		outputs[job].reset();
+	});
+
+	ofstream summary { name + ".summary" };
+	summary << setprecision(10);
+	print_summary(summary, sweep);
+	cout << "Sweep summary ..." << endl;
+	print_summary(cout, sweep);
+
+	if (!completed) {
+		log.error("The thermalization of a job failed, its statistics are NaN.");
+		return 1;
+	}
+
+	return 0;
+}
+
+int run_tempering(const Configuration& config, const string& grid, const string& format, const string& name, int interval, int threads, int window, Logger& log) {
+	vector<Configuration> configurations { };
+
+	if (!Sweep::expand(grid, config, configurations) || configurations.size() < 2) {
+		log.error("The replicas ", grid, " could not be parsed, at least two are required.");
+		return 1;
+	}
+
+	for (size_t replica = 0; replica < configurations.size(); ++replica) {
+		auto& cfg = configurations[replica];
+
+		if (cfg.nt != config.nt || cfg.dimensions != config.dimensions || cfg.nmeas != config.nmeas || cfg.ntherm != config.ntherm || cfg.target != config.target) {
+			log.error("The replicas may only differ in their couplings.");
+			return 1;
+		}
+
+		const auto reason = check_configuration(cfg, false, false);
+
+		if (reason.size() > 0) {
+			log.error("The replica ", replica, " is invalid: ", reason);
+			return 1;
+		}
+
+		seed_seq sequence { config.seed, static_cast<int>(replica) };
+		uint32_t value = 0;
+		sequence.generate(&value, &value + 1);
+		cfg.seed = static_cast<int>(value & 0x7fffffff);
+	}
+
+	vector<unique_ptr<HistoryWriter>> outputs { };
+	vector<StreamingAutoCorrelation> xsquares(configurations.size(), StreamingAutoCorrelation { window });
+	Tempering tempering { configurations, interval, threads, log };
+
+	for (size_t replica = 0; replica < configurations.size(); ++replica)
+		outputs.push_back(create_and_check(format, name + "." + to_string(replica), configurations[replica]));
+
+	cout << "Running " << configurations.size() << " replicas ..." << endl;
+
+	const auto completed = tempering.run([&outputs, &xsquares](int replica, const Measurement& measurement) {
+		outputs[replica]->write(measurement);
+		xsquares[replica].add(measurement.x_square);
+	});
+
+	for (auto& output : outputs)
+		output->close();
+
+	if (!completed)
+		return 1;
+
+	cout << "Replica statistics ..." << endl;
+	cout << "replica\tω²\tλ\tNstep\tacc\t<x>\t<x²>\tx²a\t<τi>\tστi\tswap" << endl;
+
+	for (int replica = 0; replica < tempering.replicas(); ++replica) {
+		const auto& cfg = configurations[replica];
+		const auto tau = xsquares[replica].compute();
+
+		cout << replica << '\t' << cfg.omega_square << '\t' << cfg.lambda << '\t' << tempering.steps(replica) << '\t';
+		cout << tempering.compute_acceptance(replica) << '\t' << tempering.compute_x(replica) << '\t';
+		cout << tempering.compute_x_square(replica) << '\t' << compute_analytic(cfg) << '\t' << tau.mean << '\t' << tau.uncertainty << '\t';
+
+		if (replica + 1 < tempering.replicas())
+			cout << tempering.compute_exchange(replica);
+		else
+			cout << '-';
+
+		cout << endl;
+	}
+
+	return 0;
+}
+
+int run_multilevel(const Configuration& config, const string& format, const string& name, int length, int updates, int distance, int threads, int window, Logger& log) {
+	if (length < 2 || config.nt % length != 0) {
+		log.error("The slab length ", length, " must be at least 2 and divide Nt.");
+		return 1;
+	}
+
+	if (config.omega_square <= -2.0) {
+		log.error("The multilevel scheme requires ω² > -2.");
+		return 1;
+	}
+
+	auto output = create_and_check(format, name, config);
+	StreamingAutoCorrelation xsquares { window };
+	Multilevel sim { config, length, updates, distance, threads, log };
+
+	const auto completed = sim.run([&output, &xsquares](const Measurement& measurement) {
+		output->write(measurement);
+		xsquares.add(measurement.x_square);
+	});
+
+	output->close();
+
+	if (!completed)
+		return 1;
+
+	const auto correlator = sim.compute_correlator();
+	const auto tau = xsquares.compute();
+	ofstream table { name + ".correlator" };
+	table << setprecision(10);
+	table << "t\tC\tσC\tEeff" << endl;
+
+	for (size_t t = 0; t < correlator.size(); ++t) {
+		const auto energy = t + 1 < correlator.size() ? std::log(correlator[t].mean / correlator[t + 1].mean) : nan("");
+		table << t << '\t' << correlator[t].mean << '\t' << correlator[t].uncertainty << '\t' << energy << endl;
+	}
+
 	cout << "Measurements statistics ..." << endl;
 	cout << "acc  = " << sim.compute_acceptance() << endl;
+	cout << "accs = " << sim.compute_slab_acceptance() << endl;
 	cout << "<x>  = " << sim.compute_x() << endl;
 	cout << "<x²> = " << sim.compute_x_square() << endl;
-	cout << "x²a  = " << analytic_result << endl;
+	cout << "x²a  = " << compute_analytic(config) << endl;
+	cout << "C(0) = " << correlator[0].mean << " ± " << correlator[0].uncertainty << endl;
 	cout << "<τi> = " << tau.mean << endl;
 	cout << "στi  = " << tau.uncertainty << endl;
+	cout << "The correlator has been written to " << name << ".correlator." << endl;
+	return 0;
 }
 
 int main(int argc, char** argv) {
-	vector<double> xsquares { };
-	stringstream ss { };
 	CmdParser cmd { argc, argv };
 
 	setup(cmd);
 	parse_and_exit(cmd);
 
-	ofstream output { 
-		cmd.get<string>("o") 
-	};
+	auto scheme = Scheme::leapfrog;
+
+	if (!Integrator::parse(cmd.get<string>("I"), scheme)) {
+		cerr << "Unknown integrator " << cmd.get<string>("I") << "." << endl;
+		return 1;
+	}
+
+	auto engine = numerics::Engine::mt19937;
+
+	if (!numerics::Philox::parse(cmd.get<string>("G"), engine)) {
+		cerr << "Unknown random number engine " << cmd.get<string>("G") << "." << endl;
+		return 1;
+	}
 
 	Configuration config {
 		cmd.get<int>("n"),
@@ -97,22 +533,163 @@ int main(int argc, char** argv) {
 		cmd.get<int>("i"),
 		cmd.get<double>("t"),
 		cmd.get<int>("r"),
-		cmd.get<int>("s")
+		cmd.get<int>("s"),
+		scheme,
+		cmd.get<double>("L"),
+		cmd.get<int>("R"),
+		cmd.get<bool>("F"),
+		cmd.get<double>("a"),
+		engine,
+		cmd.get<int>("d"),
+		cmd.get<int>("e")
 	};
 
+	const auto reason = check_configuration(config, cmd.get<int>("c") > 1 && cmd.get<int>("k") > 1, cmd.get<int>("M") > 0);
+
+	if (reason.size() > 0) {
+		cerr << reason << endl;
+		return 1;
+	}
+
+	if (cmd.get<int>("W") < 1) {
+		cerr << "The autocorrelation window requires a maximum lag of at least 1." << endl;
+		return 1;
+	}
+
+	if (config.domains < 1) {
+		cerr << "The lattice requires at least 1 domain." << endl;
+		return 1;
+	}
+
+	if (config.domains > 1 && (config.fourier || cmd.get<int>("c") > 1 || cmd.get<string>("T").size() > 0 || cmd.get<int>("M") > 0 || cmd.get<string>("S").size() > 0)) {
+		cerr << "The domain decomposition requires a single chain without the Fourier acceleration." << endl;
+		return 1;
+	}
+
 	cout << config << endl;
 
+	Logger log {
+		cmd.get<bool>("@") ? Level::warning : (cmd.get<bool>("v") ? Level::debug : Level::info)
+	};
+
+	log.progress(cmd.get<int>("p"), cmd.get<double>("P"));
+
+	if (engine == numerics::Engine::philox && ((cmd.get<int>("c") > 1 && cmd.get<int>("k") > 1) || cmd.get<string>("T").size() > 0 || cmd.get<int>("M") > 0))
+		log.warning("Batched chains, replicas and the multilevel scheme always use mt19937.");
+
+	if (cmd.get<string>("Z").size() > 0) {
+#if PROFILE
+		Profiler::instance().trace(trace_capacity);
+#else
+		log.warning("The phases are only timed in a build with PROFILE, e.g. defines=-DPROFILE=1.");
+#endif
+	}
+
+	if (cmd.get<string>("T").size() > 0) {
+		if (cmd.get<int>("c") > 1 || cmd.get<int>("C") > 0 || cmd.get<bool>("x"))
+			log.warning("Every replica runs a single chain without checkpoints.");
+
+		const auto code = run_tempering(config, cmd.get<string>("T"), cmd.get<string>("f"), cmd.get<string>("o"), cmd.get<int>("X"), cmd.get<int>("j"), cmd.get<int>("W"), log);
+		print_profile(cmd.get<string>("Z"), log);
+		return code;
+	}
+
+	if (cmd.get<int>("M") > 0) {
+		if (cmd.get<int>("c") > 1 || cmd.get<int>("C") > 0 || cmd.get<bool>("x"))
+			log.warning("The multilevel scheme runs a single chain without checkpoints.");
+
+		const auto code = run_multilevel(config, cmd.get<string>("f"), cmd.get<string>("o"), cmd.get<int>("M"), cmd.get<int>("U"), cmd.get<int>("D"), cmd.get<int>("j"), cmd.get<int>("W"), log);
+		print_profile(cmd.get<string>("Z"), log);
+		return code;
+	}
+
+	if (cmd.get<string>("S").size() > 0) {
+		if (cmd.get<int>("c") > 1 || cmd.get<int>("C") > 0 || cmd.get<bool>("x"))
+			log.warning("Every job of a sweep runs a single chain without checkpoints.");
+
+		const auto code = run_sweep(config, cmd.get<string>("S"), cmd.get<string>("f"), cmd.get<string>("o"), cmd.get<int>("j"), cmd.get<int>("W"), log);
+		print_profile(cmd.get<string>("Z"), log);
+		return code;
+	}
+
+	if (cmd.get<int>("c") > 1) {
+		if (cmd.get<int>("C") > 0 || cmd.get<bool>("x"))
+			log.warning("Checkpoints are only supported for a single chain.");
+
+		const auto code = run_chains(config, cmd.get<string>("f"), cmd.get<string>("o"), cmd.get<int>("c"), cmd.get<int>("j"), cmd.get<int>("k"), cmd.get<int>("W"), log);
+		print_profile(cmd.get<string>("Z"), log);
+		return code;
+	}
+
+	const auto checkpoint_name = cmd.get<string>("o") + ".checkpoint";
+	Checkpoint state { };
+	uint64_t offset = 0;
+
+	if (cmd.get<bool>("x")) {
+		try {
+			state = Checkpoint::load(checkpoint_name);
+			offset = state.get<uint64_t>();
+		} catch (const exception& error) {
+			log.error(error.what());
+			return 1;
+		}
+	}
+
+	StreamingAutoCorrelation xsquares { 
+		cmd.get<int>("W") 
+	};
+
+	Resampling samples {
+		primary::count
+	};
+
 	Harmonic sim { 
 		config, 
-		cmd.get<bool>("@") ? ss : cout, 
-		cerr 
+		log 
 	};
 
-	sim.run([&output, &xsquares](int n, double x, double xsquare, double action) {
-		output << n << "\t" << x << "\t" << xsquare << "\t" << action << endl;
-		xsquares.push_back(xsquare);
-	});
+	if (cmd.get<bool>("x")) {
+		try {
+			xsquares.load(state);
+			samples.load(state);
+			sim.load(state);
+		} catch (const exception& error) {
+			log.error(error.what());
+			return 1;
+		}
+	}
+
+	// The history is only truncated to the checkpoint once the checkpoint has been accepted.
+	auto output = create_and_check(cmd.get<string>("f"), cmd.get<string>("o"), config, offset);
+
+	const auto every = cmd.get<int>("C");
+	const auto checkpoint = [&output, &xsquares, &samples, &sim, &checkpoint_name, &log]() {
+		Checkpoint current { };
+		output->flush();
+		current.put(output->position());
+		xsquares.save(current);
+		samples.save(current);
+		sim.save(current);
+
+		if (!current.save(checkpoint_name))
+			log.warning("The checkpoint ", checkpoint_name, " could not be written.");
+	};
+
+	const auto completed = sim.run([&output, &xsquares, &samples](const Measurement& measurement) {
+		double values[primary::count];
+		output->write(measurement);
+		xsquares.add(measurement.x_square);
+		primaries(measurement, values);
+		samples.add(values);
+	}, every, every > 0 ? function<void()>(checkpoint) : nullptr);
+
+	PROFILE_CALL(report, output->close());
 
-	output.close();
-	print_result(AutoCorrelation(xsquares).compute(), compute_analytic(config), sim);
+	if (!completed)
+		return 1;
+	const auto tau = PROFILE_CALL(analysis, xsquares.compute());
+	const auto observables = estimators(config);
+	const auto estimates = PROFILE_CALL(analysis, analyze(samples, observables, tau.mean, cmd.get<int>("B"), cmd.get<int>("j"), config.seed));
+	print_result(tau, compute_analytic(config), sim, observables, estimates, samples.bin_size(tau.mean), cmd.get<int>("B"));
+	print_profile(cmd.get<string>("Z"), log);
 }
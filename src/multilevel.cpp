@@ -0,0 +1,291 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "multilevel.h"
+#include "adaptation.h"
+#include "profiling.h"
+#include <cmath>
+#include <algorithm>
+
+physics::Multilevel::Multilevel(const physics::Configuration& cfg, int length, int updates, int distance, int threads, diagnostics::Logger& log) noexcept :
+	ntherm(cfg.ntherm),
+	nmeas(cfg.nmeas),
+	nt(cfg.nt),
+	length(length),
+	updates(updates > 0 ? updates : 1),
+	distance(distance > 0 && distance < cfg.nt / 2 ? distance : cfg.nt / 2),
+	lag(std::min(this->distance, length - 2)),
+	osq(2.0 + cfg.omega_square),
+	lambda(cfg.lambda),
+	target(cfg.target),
+	delta(0.0),
+	log(log),
+	rng(cfg.seed),
+	dist(0.0, 1.0),
+	lattice(rng, cfg.nt, Integrator { cfg.integrator, cfg.nstep, cfg.tau, cfg.omelyan, cfg.substeps }, cfg.omega_square, cfg.lambda, cfg.fourier),
+	rngs(),
+	pool(std::min(threads > 0 ? threads : concurrency::ThreadPool::hardware_threads(), cfg.nt / length)),
+	fft(static_cast<std::size_t>(cfg.nt)),
+	sites(cfg.nt),
+	means(cfg.nt),
+	products((cfg.nt / length) * (lag + 1)),
+	accepted(cfg.nt / length, 0.0),
+	correlation(cfg.nt),
+	spectrum(cfg.nt / 2 + 1),
+	csum(this->distance + 1, 0.0),
+	csqsum(this->distance + 1, 0.0),
+	acr(0.0),
+	xsm(0.0),
+	xsqm(0.0) {
+	for (int s = 0; s < slabs(); ++s) {
+		std::seed_seq sequence { cfg.seed, s + 1 };
+		rngs.emplace_back(sequence);
+	}
+}
+
+int physics::Multilevel::slabs() const noexcept {
+	return nt / length;
+}
+
+bool physics::Multilevel::run(std::function<void(const physics::Measurement&)> report) noexcept {
+	init();
+
+	if (!thermalize())
+		return false;
+
+	measure(report);
+	return true;
+}
+
+void physics::Multilevel::init() noexcept {
+	// The initial trajectories are not checked, hence they could diverge for a step size that still needs to be adapted.
+	if (target > 0.0)
+		return;
+
+	for (int n = 0; n < 10; ++n) {
+		lattice.randomize();
+		lattice.integrate();
+	}
+}
+
+bool physics::Multilevel::thermalize() noexcept {
+	log.info("Running thermalization ...");
+	DualAveraging adaptation { target, lattice.step_size() };
+	const auto adapting = target > 0.0;
+	auto arate = 0.0;
+
+	for (int n = 0; n < ntherm; ++n) {
+		arate += step();
+
+		if (adapting) {
+			const auto probability = delta > 0.0 ? exp(-delta) : (delta <= 0.0 ? 1.0 : 0.0);
+			lattice.step_size(adaptation.update(probability));
+		}
+	}
+
+	log.info("Thermalization finished!");
+
+	if (adapting) {
+		lattice.step_size(adaptation.average());
+		log.info("Adapted the step size to ε = ", lattice.step_size(), " with ", lattice.steps(), " steps for an acceptance of ", target, ".");
+
+		if (4.0 * arate < ntherm)
+			log.warning("Low acceptance rate during the adaptation of the step size!");
+	} else if (4.0 * arate < ntherm) {
+		log.error("Bad acceptance rate in thermalisation!");
+		return false;
+	}
+
+	return true;
+}
+
+void physics::Multilevel::measure(std::function<void(const physics::Measurement&)> report) noexcept {
+	log.info("Starting measurements with ", slabs(), " slabs of ", length, " sites ...");
+	diagnostics::Progress progress { log, "Measurements", nmeas };
+
+	for (int n = 0; n < nmeas; ++n) {
+		const auto accept = step();
+		const auto xs = PROFILE_CALL(observables, lattice.x_average());
+		const auto xsq = PROFILE_CALL(observables, lattice.x_square_average());
+		const auto act = PROFILE_CALL(observables, lattice.action_average());
+
+		PROFILE_CALL(report, report(physics::Measurement { n, xs, xsq, act, accept }));
+		progress.update(accept, xs, xsq);
+		acr += accept;
+		xsm += xs;
+		xsqm += xsq;
+
+		for (int i = 0; i < nt; ++i)
+			sites[i] = lattice.x(i);
+
+		pool.run(slabs(), [this](int s) {
+			update(s);
+		});
+
+		for (int i = 0; i < nt; ++i)
+			lattice.x(i, sites[i]);
+
+		correlate();
+	}
+
+	progress.finish();
+	log.info("Measurements finished!");
+}
+
+bool physics::Multilevel::step() noexcept {
+	PROFILE_CALL(randomize, lattice.randomize());
+	lattice.store();
+	const auto a = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_CALL(integrate, lattice.integrate());
+	const auto b = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_SCOPE(metropolis);
+	delta = b - a;
+	const auto accept = delta <= 0.0 || dist(rng) <= exp(-delta);
+
+	if (!accept)
+		lattice.restore();
+
+	return accept;
+}
+
+void physics::Multilevel::update(int slab) noexcept {
+	using std::sqrt;
+	using std::exp;
+
+	auto& engine = rngs[slab];
+	std::normal_distribution<double> gauss { 0.0, 1.0 / sqrt(osq) };
+	std::uniform_real_distribution<double> uniform { 0.0, 1.0 };
+	const auto first = slab * length;
+	const auto last = first + length;
+	const auto right = sites[last % nt];
+	auto* x = sites.data();
+	auto* m = means.data();
+	auto* c = products.data() + slab * (lag + 1);
+	auto hits = 0.0;
+
+	m[first] = x[first];
+	std::fill(m + first + 1, m + last, 0.0);
+	std::fill(c, c + lag + 1, 0.0);
+
+	for (int u = 0; u < updates; ++u) {
+		for (int i = first + 1; i < last; ++i) {
+			const auto neighbours = x[i - 1] + (i + 1 < last ? x[i + 1] : right);
+			const auto proposal = neighbours / osq + gauss(engine);
+			const auto xo = x[i] * x[i];
+			const auto xn = proposal * proposal;
+
+			if (lambda == 0.0 || uniform(engine) <= exp(-lambda * (xn * xn - xo * xo))) {
+				x[i] = proposal;
+				hits += 1.0;
+			}
+		}
+
+		for (int i = first + 1; i < last; ++i)
+			m[i] += x[i];
+
+		for (int t = 0; t <= lag; ++t) {
+			auto sum = 0.0;
+
+			for (int i = first + 1; i + t < last; ++i)
+				sum += x[i] * x[i + t];
+
+			c[t] += sum;
+		}
+	}
+
+	const auto scale = 1.0 / static_cast<double>(updates);
+
+	for (int i = first + 1; i < last; ++i)
+		m[i] *= scale;
+
+	for (int t = 0; t <= lag; ++t)
+		c[t] *= scale;
+
+	accepted[slab] += hits / static_cast<double>(updates * (length - 1));
+}
+
+void physics::Multilevel::correlate() noexcept {
+	using std::norm;
+
+	// The cyclic autocorrelation of the sub-averages is exact for sites of different slabs.
+	fft.forward(means.data(), spectrum.data());
+
+	for (auto& value : spectrum)
+		value = norm(value);
+
+	fft.inverse(spectrum.data(), correlation.data());
+
+	// Pairs within the interior of a slab are not independent, hence their products are taken from the sub-averages.
+	for (int s = 0; s < slabs(); ++s) {
+		const auto first = s * length;
+		const auto last = first + length;
+		const auto* c = products.data() + s * (lag + 1);
+
+		for (int t = 0; t <= lag; ++t) {
+			auto sum = 0.0;
+
+			for (int i = first + 1; i + t < last; ++i)
+				sum += means[i] * means[i + t];
+
+			correlation[t] += c[t] - sum;
+		}
+	}
+
+	for (int t = 0; t <= distance; ++t) {
+		const auto value = correlation[t] / static_cast<double>(nt);
+		csum[t] += value;
+		csqsum[t] += value * value;
+	}
+}
+
+double physics::Multilevel::compute_acceptance() const noexcept {
+	return acr / static_cast<double>(nmeas);
+}
+
+double physics::Multilevel::compute_slab_acceptance() const noexcept {
+	auto sum = 0.0;
+
+	for (const auto rate : accepted)
+		sum += rate;
+
+	return sum / static_cast<double>(slabs() * nmeas);
+}
+
+double physics::Multilevel::compute_x() const noexcept {
+	return xsm / static_cast<double>(nmeas);
+}
+
+double physics::Multilevel::compute_x_square() const noexcept {
+	return xsqm / static_cast<double>(nmeas);
+}
+
+std::vector<statistics::Observable<double>> physics::Multilevel::compute_correlator() const noexcept {
+	using std::sqrt;
+
+	const auto n = static_cast<double>(nmeas);
+	std::vector<statistics::Observable<double>> result { };
+
+	for (int t = 0; t <= distance; ++t) {
+		const auto mean = csum[t] / n;
+		const auto var = csqsum[t] / n - mean * mean;
+		result.push_back(statistics::Observable<double> { mean, n > 1.0 && var > 0.0 ? sqrt(var / (n - 1.0)) : 0.0 });
+	}
+
+	return result;
+}
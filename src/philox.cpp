@@ -0,0 +1,161 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "philox.h"
+#include "gaussian.h"
+
+namespace {
+	const std::uint32_t multiplier0 = 0xD2511F53;
+	const std::uint32_t multiplier1 = 0xCD9E8D57;
+	const std::uint32_t weyl0 = 0x9E3779B9;
+	const std::uint32_t weyl1 = 0xBB67AE85;
+
+	/**
+	* The number of counters that are computed together, i.e. a block of the Box-Muller transform.
+	*/
+	const int lanes = numerics::Gaussian::block_size;
+
+	/**
+	* Converts 64 random bits to a double in (0, 1), which can be passed to a logarithm.
+	*
+	* @param The upper 32 bits.
+	* @param The lower 32 bits.
+	* @return The uniform value.
+	*/
+	inline double to_unit(std::uint32_t hi, std::uint32_t lo) noexcept {
+		const auto bits = ((static_cast<std::uint64_t>(hi) << 32) | lo) >> 11;
+		return (static_cast<double>(bits) + 0.5) * (1.0 / 9007199254740992.0);
+	}
+
+	inline numerics::Philox::block_type make_counter(std::uint64_t index, std::uint64_t trajectory, numerics::Philox::Purpose purpose) noexcept {
+		return numerics::Philox::block_type {{
+			static_cast<std::uint32_t>(index),
+			static_cast<std::uint32_t>(trajectory),
+			static_cast<std::uint32_t>(trajectory >> 32),
+			static_cast<std::uint32_t>(purpose) | static_cast<std::uint32_t>(index >> 32) << 2
+		}};
+	}
+}
+
+numerics::Philox::Philox(std::uint32_t seed, std::uint32_t stream) noexcept :
+	key {{ seed, stream }},
+	position(0) {
+}
+
+numerics::Philox::block_type numerics::Philox::block(block_type c, std::uint32_t k0, std::uint32_t k1) noexcept {
+	for (int round = 0; round < 10; ++round) {
+		const auto p0 = static_cast<std::uint64_t>(multiplier0) * c[0];
+		const auto p1 = static_cast<std::uint64_t>(multiplier1) * c[2];
+		c = block_type {{
+			static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k0,
+			static_cast<std::uint32_t>(p1),
+			static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k1,
+			static_cast<std::uint32_t>(p0)
+		}};
+		k0 += weyl0;
+		k1 += weyl1;
+	}
+
+	return c;
+}
+
+void numerics::Philox::gaussians(double* target, int n, std::uint64_t trajectory, int offset) const noexcept {
+	const auto pairs = (n + 1) / 2;
+	const auto base = offset / 2;
+	std::uint32_t c0[lanes];
+	std::uint32_t c1[lanes];
+	std::uint32_t c2[lanes];
+	std::uint32_t c3[lanes];
+	std::uint64_t radii[lanes];
+	std::uint64_t angles[lanes];
+
+	// The rounds are applied to a batch of counters at once, which the compiler can vectorize.
+	for (int first = 0; first < pairs; first += lanes) {
+		auto k0 = key[0];
+		auto k1 = key[1];
+
+		for (int l = 0; l < lanes; ++l) {
+			c0[l] = static_cast<std::uint32_t>(base + first + l);
+			c1[l] = static_cast<std::uint32_t>(trajectory);
+			c2[l] = static_cast<std::uint32_t>(trajectory >> 32);
+			c3[l] = static_cast<std::uint32_t>(Purpose::momenta);
+		}
+
+		for (int round = 0; round < 10; ++round) {
+			for (int l = 0; l < lanes; ++l) {
+				const auto p0 = static_cast<std::uint64_t>(multiplier0) * c0[l];
+				const auto p1 = static_cast<std::uint64_t>(multiplier1) * c2[l];
+				c0[l] = static_cast<std::uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+				c1[l] = static_cast<std::uint32_t>(p1);
+				c2[l] = static_cast<std::uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+				c3[l] = static_cast<std::uint32_t>(p0);
+			}
+
+			k0 += weyl0;
+			k1 += weyl1;
+		}
+
+		for (int l = 0; l < lanes; ++l) {
+			radii[l] = (static_cast<std::uint64_t>(c0[l]) << 32) | c1[l];
+			angles[l] = (static_cast<std::uint64_t>(c2[l]) << 32) | c3[l];
+		}
+
+		const auto count = n - 2 * first < 2 * lanes ? n - 2 * first : 2 * lanes;
+		Gaussian::transform(target + 2 * first, radii, angles, count);
+	}
+}
+
+double numerics::Philox::uniform(std::uint64_t trajectory, Purpose purpose, std::uint32_t index) const noexcept {
+	const auto bits = block(make_counter(index, trajectory, purpose), key[0], key[1]);
+	return to_unit(bits[0], bits[1]);
+}
+
+numerics::Philox::result_type numerics::Philox::operator()() noexcept {
+	const auto bits = block(make_counter(position / 4, 0, Purpose::sequence), key[0], key[1]);
+	return bits[position++ % 4];
+}
+
+void numerics::Philox::seed(std::uint32_t seed) noexcept {
+	key[0] = seed;
+	position = 0;
+}
+
+void numerics::Philox::discard(std::uint64_t count) noexcept {
+	position += count;
+}
+
+const char* numerics::Philox::name(Engine engine) noexcept {
+	switch (engine) {
+		case Engine::philox:
+			return "philox";
+		default:
+			return "mt19937";
+	}
+}
+
+bool numerics::Philox::parse(const std::string& name, Engine& engine) noexcept {
+	if (name == "mt19937")
+		engine = Engine::mt19937;
+	else if (name == "philox")
+		engine = Engine::philox;
+	else
+		return false;
+
+	return true;
+}
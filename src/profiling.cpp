@@ -0,0 +1,150 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "profiling.h"
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+diagnostics::Profiler::Profiler() noexcept :
+	origin(std::chrono::steady_clock::now()),
+	mutex(),
+	events(),
+	threads(),
+	capacity(0),
+	dropped(0) {
+	for (int i = 0; i < phases; ++i) {
+		durations[i] = 0;
+		counts[i] = 0;
+	}
+}
+
+diagnostics::Profiler& diagnostics::Profiler::instance() noexcept {
+	static Profiler profiler { };
+	return profiler;
+}
+
+void diagnostics::Profiler::record(Phase phase, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) noexcept {
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+
+	const auto index = static_cast<int>(phase);
+	const auto ns = duration_cast<nanoseconds>(end - begin).count();
+	durations[index] += ns;
+	++counts[index];
+
+	if (capacity == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock { mutex };
+
+	if (events.size() < capacity)
+		events.push_back(TraceEvent { phase, thread(), duration_cast<nanoseconds>(begin - origin).count(), ns });
+	else
+		++dropped;
+}
+
+void diagnostics::Profiler::trace(std::size_t capacity) noexcept {
+	std::lock_guard<std::mutex> lock { mutex };
+	events.reserve(std::min<std::size_t>(capacity, 1 << 16));
+	this->capacity = capacity;
+}
+
+int diagnostics::Profiler::thread() noexcept {
+	const auto id = std::this_thread::get_id();
+
+	for (std::size_t i = 0; i < threads.size(); ++i) {
+		if (threads[i] == id)
+			return static_cast<int>(i);
+	}
+
+	threads.push_back(id);
+	return static_cast<int>(threads.size() - 1);
+}
+
+double diagnostics::Profiler::seconds(Phase phase) const noexcept {
+	return 1e-9 * static_cast<double>(durations[static_cast<int>(phase)].load());
+}
+
+long long diagnostics::Profiler::calls(Phase phase) const noexcept {
+	return counts[static_cast<int>(phase)].load();
+}
+
+void diagnostics::Profiler::summarize(std::ostream& os) const noexcept {
+	auto total = 0.0;
+
+	for (int i = 0; i < phases; ++i)
+		total += seconds(static_cast<Phase>(i));
+
+	os << "Time per phase ..." << std::endl;
+
+	for (int i = 0; i < phases; ++i) {
+		const auto phase = static_cast<Phase>(i);
+		const auto n = calls(phase);
+
+		if (n == 0)
+			continue;
+
+		os << std::left << std::setw(12) << name(phase) << std::right << " = " << seconds(phase) << " s";
+		os << " (" << n << " calls, " << 1e9 * seconds(phase) / static_cast<double>(n) << " ns/call, ";
+		os << 100.0 * seconds(phase) / total << "%)" << std::endl;
+	}
+}
+
+bool diagnostics::Profiler::write_trace(const std::string& name) noexcept {
+	std::lock_guard<std::mutex> lock { mutex };
+	std::ofstream output { name };
+
+	if (!output.is_open())
+		return false;
+
+	output << std::fixed << std::setprecision(3);
+	output << "{\"displayTimeUnit\":\"ns\",\"droppedEvents\":" << dropped << ",\"traceEvents\":[";
+
+	for (std::size_t i = 0; i < events.size(); ++i) {
+		const auto& e = events[i];
+		output << (i > 0 ? ",\n" : "\n");
+		output << "{\"name\":\"" << Profiler::name(e.phase) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread;
+		output << ",\"ts\":" << 1e-3 * static_cast<double>(e.begin) << ",\"dur\":" << 1e-3 * static_cast<double>(e.duration) << "}";
+	}
+
+	output << "\n]}" << std::endl;
+	return output.good();
+}
+
+const char* diagnostics::Profiler::name(Phase phase) noexcept {
+	switch (phase) {
+		case Phase::randomize:
+			return "randomize";
+		case Phase::integrate:
+			return "integrate";
+		case Phase::hamilton:
+			return "hamilton";
+		case Phase::metropolis:
+			return "metropolis";
+		case Phase::observables:
+			return "observables";
+		case Phase::report:
+			return "report";
+		case Phase::analysis:
+			return "analysis";
+		default:
+			return "unknown";
+	}
+}
@@ -0,0 +1,253 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "resampling.h"
+#include "philox.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+using std::size_t;
+
+/**
+* The minimum number of integrated autocorrelation times per bin.
+*/
+const double bin_times = 8.0;
+
+/**
+* The minimum number of bins of the resampling, which limits the size of the bins of short series.
+*/
+const size_t min_bins = 32;
+
+/**
+* The number of chunks of the jackknife per thread, which balances the load.
+*/
+const int chunks_per_thread = 4;
+
+const int statistics::Resampling::max_observables;
+
+statistics::Resampling::Resampling(int observables, int capacity) noexcept :
+	observables(std::min(std::max(observables, 1), max_observables)),
+	capacity(std::max(capacity / 2 * 2, 2)),
+	n(0),
+	width(1),
+	filled(0),
+	pending(0),
+	bins(static_cast<size_t>(this->capacity) * this->observables, 0.0),
+	partial(this->observables, 0.0) {
+}
+
+void statistics::Resampling::add(const double* values) noexcept {
+	for (int k = 0; k < observables; ++k)
+		partial[k] += values[k];
+
+	++n;
+
+	if (++pending < width)
+		return;
+
+	if (filled == static_cast<size_t>(capacity))
+		coarsen();
+
+	// A coarsening doubles the width, hence the partial bin may not be complete anymore.
+	if (pending < width)
+		return;
+
+	std::copy(partial.begin(), partial.end(), bins.begin() + filled * observables);
+	std::fill(partial.begin(), partial.end(), 0.0);
+	pending = 0;
+	++filled;
+}
+
+void statistics::Resampling::coarsen() noexcept {
+	const auto m = static_cast<size_t>(observables);
+
+	for (size_t i = 0; i < filled / 2; ++i) {
+		for (size_t k = 0; k < m; ++k)
+			bins[i * m + k] = bins[2 * i * m + k] + bins[(2 * i + 1) * m + k];
+	}
+
+	std::fill(bins.begin() + filled / 2 * m, bins.end(), 0.0);
+	filled /= 2;
+	width *= 2;
+}
+
+size_t statistics::Resampling::count() const noexcept {
+	return n;
+}
+
+size_t statistics::Resampling::bin_size(double tau) const noexcept {
+	const auto wanted = std::isfinite(tau) ? std::max(1.0, std::ceil(bin_times * tau)) : 1.0;
+	const auto most = std::max(filled / min_bins, static_cast<size_t>(1));
+	const auto factor = std::min(static_cast<size_t>(std::ceil(wanted / width)), most);
+	return std::max(factor, static_cast<size_t>(1)) * width;
+}
+
+std::vector<statistics::Estimate> statistics::Resampling::compute(const std::vector<Estimator>& estimators, double tau, int replicas, std::uint32_t seed, concurrency::ThreadPool& pool) const noexcept {
+	using std::sqrt;
+
+	const auto m = static_cast<size_t>(observables);
+	const auto count = estimators.size();
+	const auto nan = std::numeric_limits<double>::quiet_NaN();
+	std::vector<Estimate> result(count, Estimate { nan, nan, nan });
+
+	if (n == 0)
+		return result;
+
+	double means[max_observables];
+
+	for (size_t k = 0; k < m; ++k) {
+		auto total = partial[k];
+
+		for (size_t i = 0; i < filled; ++i)
+			total += bins[i * m + k];
+
+		means[k] = total / static_cast<double>(n);
+	}
+
+	for (size_t e = 0; e < count; ++e)
+		result[e].mean = estimators[e](means);
+
+	const auto size = bin_size(tau);
+	const auto factor = size / width;
+	const auto nb = filled / factor;
+
+	if (nb < 2)
+		return result;
+
+	// The kept bins are combined into the bins of the resampling, a remainder is dropped.
+	std::vector<double> coarse(nb * m, 0.0);
+	double totals[max_observables] = { };
+
+	for (size_t i = 0; i < nb * factor; ++i) {
+		for (size_t k = 0; k < m; ++k)
+			coarse[i / factor * m + k] += bins[i * m + k];
+	}
+
+	for (size_t i = 0; i < nb; ++i) {
+		for (size_t k = 0; k < m; ++k)
+			totals[k] += coarse[i * m + k];
+	}
+
+	// The jackknife leaves out one bin at a time.
+	std::vector<double> samples(nb * count);
+	const auto chunks = static_cast<int>(std::min(nb, static_cast<size_t>(pool.size() * chunks_per_thread)));
+	const auto remaining = static_cast<double>((nb - 1) * size);
+
+	pool.run(chunks, [&](int chunk) {
+		double sample[max_observables];
+
+		for (auto i = nb * chunk / chunks; i < nb * (chunk + 1) / chunks; ++i) {
+			for (size_t k = 0; k < m; ++k)
+				sample[k] = (totals[k] - coarse[i * m + k]) / remaining;
+
+			for (size_t e = 0; e < count; ++e)
+				samples[i * count + e] = estimators[e](sample);
+		}
+	});
+
+	for (size_t e = 0; e < count; ++e) {
+		auto average = 0.0;
+		auto variance = 0.0;
+
+		for (size_t i = 0; i < nb; ++i)
+			average += samples[i * count + e];
+
+		average /= static_cast<double>(nb);
+
+		for (size_t i = 0; i < nb; ++i)
+			variance += (samples[i * count + e] - average) * (samples[i * count + e] - average);
+
+		result[e].jackknife = sqrt(variance * static_cast<double>(nb - 1) / static_cast<double>(nb));
+	}
+
+	if (replicas < 2)
+		return result;
+
+	// Every replica draws nb bins with replacement from the counters of its own Philox stream.
+	std::vector<double> draws(static_cast<size_t>(replicas) * count);
+	const auto used = static_cast<double>(nb * size);
+
+	pool.run(replicas, [&](int replica) {
+		double sums[max_observables] = { };
+		numerics::Philox::block_type bits { };
+
+		for (size_t i = 0; i < nb; ++i) {
+			if (i % 4 == 0)
+				bits = numerics::Philox::block({ { static_cast<std::uint32_t>(i / 4), static_cast<std::uint32_t>(replica), 0, 0 } }, seed, 0);
+
+			const auto j = static_cast<size_t>((static_cast<std::uint64_t>(bits[i % 4]) * nb) >> 32);
+
+			for (size_t k = 0; k < m; ++k)
+				sums[k] += coarse[j * m + k];
+		}
+
+		for (size_t k = 0; k < m; ++k)
+			sums[k] /= used;
+
+		for (size_t e = 0; e < count; ++e)
+			draws[replica * count + e] = estimators[e](sums);
+	});
+
+	for (size_t e = 0; e < count; ++e) {
+		auto average = 0.0;
+		auto variance = 0.0;
+
+		for (int r = 0; r < replicas; ++r)
+			average += draws[r * count + e];
+
+		average /= replicas;
+
+		for (int r = 0; r < replicas; ++r)
+			variance += (draws[r * count + e] - average) * (draws[r * count + e] - average);
+
+		result[e].bootstrap = sqrt(variance / (replicas - 1));
+	}
+
+	return result;
+}
+
+void statistics::Resampling::save(io::Checkpoint& checkpoint) const noexcept {
+	checkpoint.put(observables);
+	checkpoint.put(capacity);
+	checkpoint.put(static_cast<std::uint64_t>(n));
+	checkpoint.put(static_cast<std::uint64_t>(width));
+	checkpoint.put(static_cast<std::uint64_t>(filled));
+	checkpoint.put(static_cast<std::uint64_t>(pending));
+	checkpoint.put(bins.data(), filled * observables);
+	checkpoint.put(partial.data(), partial.size());
+}
+
+void statistics::Resampling::load(io::Checkpoint& checkpoint) {
+	if (checkpoint.get<int>() != observables || checkpoint.get<int>() != capacity)
+		throw std::runtime_error("The checkpoint does not match the resampling bins.");
+
+	n = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+	width = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+	filled = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+	pending = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+
+	if (width == 0 || filled > static_cast<size_t>(capacity))
+		throw std::runtime_error("The checkpoint contains invalid resampling bins.");
+
+	std::fill(bins.begin(), bins.end(), 0.0);
+	checkpoint.get(bins.data(), filled * observables);
+	checkpoint.get(partial.data(), partial.size());
+}
@@ -0,0 +1,226 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "streaming.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+using std::size_t;
+
+/**
+* The minimum number of bins a level needs to contribute to the binning error.
+*/
+const size_t min_bins = 32;
+
+statistics::StreamingAutoCorrelation::StreamingAutoCorrelation(int window, int lambda) noexcept :
+	window(window),
+	lambda(lambda),
+	n(0),
+	shift(0.0),
+	sum(0.0),
+	head(),
+	recent(window, 0.0),
+	products(window, 0.0),
+	bins() {
+	head.reserve(window);
+}
+
+void statistics::StreamingAutoCorrelation::add(double value) noexcept {
+	if (n == 0)
+		shift = value;
+
+	const auto y = value - shift;
+	const auto w = static_cast<size_t>(window);
+	const auto lags = std::min(n + 1, w);
+	recent[n % w] = y;
+
+	for (size_t t = 0; t < lags; ++t)
+		products[t] += y * recent[(n - t) % w];
+
+	if (n < w)
+		head.push_back(y);
+
+	sum += y;
+	++n;
+	bin(0, y);
+}
+
+void statistics::StreamingAutoCorrelation::bin(size_t level, double value) noexcept {
+	for (;;) {
+		if (level == bins.size())
+			bins.push_back(Bin { 0.0, false, 0.0, 0.0, 0 });
+
+		auto& current = bins[level];
+		current.sum += value;
+		current.sum_square += value * value;
+		++current.count;
+
+		if (!current.filled) {
+			current.pending = value;
+			current.filled = true;
+			return;
+		}
+
+		value = 0.5 * (current.pending + value);
+		current.filled = false;
+		++level;
+	}
+}
+
+void statistics::StreamingAutoCorrelation::save(io::Checkpoint& checkpoint) const noexcept {
+	checkpoint.put(window);
+	checkpoint.put(lambda);
+	checkpoint.put(static_cast<std::uint64_t>(n));
+	checkpoint.put(shift);
+	checkpoint.put(sum);
+	checkpoint.put(head.data(), head.size());
+	checkpoint.put(recent.data(), recent.size());
+	checkpoint.put(products.data(), products.size());
+	checkpoint.put(static_cast<std::uint64_t>(bins.size()));
+
+	for (const auto& current : bins) {
+		checkpoint.put(current.pending);
+		checkpoint.put(current.filled);
+		checkpoint.put(current.sum);
+		checkpoint.put(current.sum_square);
+		checkpoint.put(static_cast<std::uint64_t>(current.count));
+	}
+}
+
+void statistics::StreamingAutoCorrelation::load(io::Checkpoint& checkpoint) {
+	if (checkpoint.get<int>() != window || checkpoint.get<int>() != lambda)
+		throw std::runtime_error("The checkpoint does not match the autocorrelation window.");
+
+	n = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+	shift = checkpoint.get<double>();
+	sum = checkpoint.get<double>();
+	checkpoint.get(head);
+	checkpoint.get(recent.data(), recent.size());
+	checkpoint.get(products.data(), products.size());
+	bins.resize(static_cast<size_t>(checkpoint.get<std::uint64_t>()));
+
+	for (auto& current : bins) {
+		current.pending = checkpoint.get<double>();
+		current.filled = checkpoint.get<bool>();
+		current.sum = checkpoint.get<double>();
+		current.sum_square = checkpoint.get<double>();
+		current.count = static_cast<size_t>(checkpoint.get<std::uint64_t>());
+	}
+}
+
+size_t statistics::StreamingAutoCorrelation::count() const noexcept {
+	return n;
+}
+
+statistics::Observable<double> statistics::StreamingAutoCorrelation::mean() const noexcept {
+	using std::sqrt;
+	using std::max;
+
+	if (n == 0)
+		return statistics::Observable<double> { 0.0, 0.0 };
+
+	auto error = 0.0;
+
+	for (size_t level = 0; level < bins.size(); ++level) {
+		const auto& current = bins[level];
+
+		if (current.count < 2 || (level > 0 && current.count < min_bins))
+			break;
+
+		const auto c = static_cast<double>(current.count);
+		const auto var = max(current.sum_square - current.sum * current.sum / c, 0.0);
+		error = max(error, sqrt(var / (c * (c - 1.0))));
+	}
+
+	return statistics::Observable<double> { shift + sum / static_cast<double>(n), error };
+}
+
+double statistics::StreamingAutoCorrelation::auto_corr(int tmax, double* g) const noexcept {
+	using std::abs;
+	using std::sqrt;
+	using std::numeric_limits;
+
+	const auto w = static_cast<size_t>(window);
+	const auto xn = static_cast<double>(n);
+	const auto avg = sum / xn;
+	const auto var = products[0] - xn * avg * avg;
+
+	if (var <= 0.0 || sqrt(var / (xn * (xn - 1.0))) <= (10.0 * numeric_limits<double>::epsilon() * abs(shift + avg))) {
+		for (int t = 0; t < tmax; ++t)
+			g[t] = 0.0;
+
+		return 0.0;
+	}
+
+	const auto g0 = var / xn;
+	auto first = 0.0;
+	auto last = 0.0;
+	g[0] = 1.0;
+
+	for (int t = 1; t < tmax; ++t) {
+		const auto m = static_cast<double>(n - t);
+		first += head[t - 1];
+		last += recent[(n - t) % w];
+		const auto cov = products[t] - avg * ((sum - last) + (sum - first)) + m * avg * avg;
+		g[t] = cov / (g0 * m);
+	}
+
+	return g0;
+}
+
+statistics::Observable<double> statistics::StreamingAutoCorrelation::compute() const noexcept {
+	using std::sqrt;
+	using std::pow;
+	using std::abs;
+	using std::min;
+
+	const auto lags = static_cast<int>(min(n, static_cast<size_t>(window)));
+	const auto tmax = min((static_cast<int>(n) - lambda) / 2, (lags + 1 - lambda) / 2);
+	const auto xn = static_cast<double>(n);
+	auto sigma = 0.0;
+	auto tau = 0.5;
+
+	if (tmax < 2)
+		return statistics::Observable<double> { tau, sigma };
+
+	std::vector<double> g(lags);
+	const auto g0 = auto_corr(lags, g.data());
+	auto w = tmax;
+
+	if (g0 != 0.0) {
+		for (int t = 1; t < w; ++t) {
+			auto sm = 0.0;
+			tau += g[t];
+
+			for (int k = 1; k <= (t + lambda); ++k)
+				sm += pow(g[k + t] + g[abs(k - t)] - 2.0 * g[t] * g[k], 2);
+
+			if (g[t] <= sqrt(sm / xn)) {
+				w = t;
+				break;
+			}
+		}
+
+		sigma = tau * sqrt((2.0 / xn) * ((2 * w + 1) - 3.0 * tau + 1.0 / (4.0 * tau)));
+	}
+
+	return statistics::Observable<double> { tau, sigma };
+}
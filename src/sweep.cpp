@@ -0,0 +1,255 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "sweep.h"
+#include "harmonic.h"
+#include "integrator.h"
+#include "threadpool.h"
+#include "streaming.h"
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+	/**
+	* A parameter of the configuration that can be varied by a sweep.
+	*/
+	struct Parameter {
+		const char* name;
+		const char* alternative;
+		std::function<void(physics::Configuration&, double)> assign;
+	};
+
+	int to_int(double value) noexcept {
+		return static_cast<int>(std::lround(value));
+	}
+
+	const std::vector<Parameter>& parameters() noexcept {
+		using physics::Configuration;
+
+		static const std::vector<Parameter> all {
+			{ "n", "nt", [](Configuration& c, double v) { c.nt = to_int(v); } },
+			{ "d", "dimensions", [](Configuration& c, double v) { c.dimensions = to_int(v); } },
+			{ "w", "omegasq", [](Configuration& c, double v) { c.omega_square = v; } },
+			{ "l", "lambda", [](Configuration& c, double v) { c.lambda = v; } },
+			{ "t", "tau", [](Configuration& c, double v) { c.tau = v; } },
+			{ "r", "nsteps", [](Configuration& c, double v) { c.nstep = to_int(v); } },
+			{ "L", "omelyan", [](Configuration& c, double v) { c.omelyan = v; } },
+			{ "R", "substeps", [](Configuration& c, double v) { c.substeps = to_int(v); } },
+			{ "a", "adapt", [](Configuration& c, double v) { c.target = v; } },
+			{ "m", "nmeas", [](Configuration& c, double v) { c.nmeas = to_int(v); } },
+			{ "i", "ninit", [](Configuration& c, double v) { c.ntherm = to_int(v); } },
+			{ "s", "seed", [](Configuration& c, double v) { c.seed = to_int(v); } }
+		};
+
+		return all;
+	}
+
+	std::vector<std::string> split(const std::string& text, const std::string& separators) noexcept {
+		std::vector<std::string> parts { };
+		std::string::size_type begin = 0;
+
+		while (begin < text.size()) {
+			const auto end = std::min(text.find_first_of(separators, begin), text.size());
+
+			if (end > begin)
+				parts.push_back(text.substr(begin, end - begin));
+
+			begin = end + 1;
+		}
+
+		return parts;
+	}
+
+	bool to_double(const std::string& text, double& value) noexcept {
+		try {
+			std::size_t length = 0;
+			value = std::stod(text, &length);
+			return length == text.size();
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	bool parse_values(const std::string& text, std::vector<double>& values) noexcept {
+		for (const auto& item : split(text, ",")) {
+			const auto bounds = split(item, ":");
+			auto first = 0.0;
+			auto last = 0.0;
+			auto increment = 1.0;
+
+			if (bounds.size() == 1 && to_double(bounds[0], first)) {
+				values.push_back(first);
+				continue;
+			}
+
+			if (bounds.size() < 2 || bounds.size() > 3 || !to_double(bounds[0], first) || !to_double(bounds[1], last))
+				return false;
+
+			if (bounds.size() == 3 && !to_double(bounds[2], increment))
+				return false;
+
+			const auto span = (last - first) / increment;
+
+			if (increment == 0.0 || span < 0.0)
+				return false;
+
+			const auto count = static_cast<int>(std::floor(span + 1e-9)) + 1;
+
+			for (int k = 0; k < count; ++k)
+				values.push_back(first + k * increment);
+		}
+
+		return values.size() > 0;
+	}
+}
+
+physics::Sweep::Sweep(const std::vector<physics::Configuration>& configurations, int threads, int window, diagnostics::Logger& log) noexcept :
+	jobs(configurations),
+	threads(threads > 0 ? threads : concurrency::ThreadPool::hardware_threads()),
+	window(window),
+	log(log),
+	job_results(configurations.size()),
+	job_durations(configurations.size(), 0.0) {
+}
+
+double physics::Sweep::cost(const physics::Configuration& cfg) noexcept {
+	using std::log2;
+
+	const Integrator integrator { cfg.integrator, std::max(cfg.nstep, 1), cfg.tau, cfg.omelyan, cfg.substeps };
+	const auto sites = static_cast<double>(Lattice::sites(cfg.nt, cfg.dimensions));
+	const auto trajectories = static_cast<double>(cfg.nmeas + cfg.ntherm);
+	const auto forces = static_cast<double>(integrator.force_evaluations(Force::full) + 
+		integrator.force_evaluations(Force::harmonic) + integrator.force_evaluations(Force::anharmonic));
+	const auto transforms = cfg.fourier ? 1.0 + log2(sites) : 1.0;
+	return sites * forces * transforms * trajectories;
+}
+
+std::vector<int> physics::Sweep::schedule() const noexcept {
+	std::vector<int> order(jobs.size());
+	std::vector<double> costs { };
+
+	for (const auto& job : jobs)
+		costs.push_back(cost(job));
+
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&costs](int a, int b) {
+		return costs[a] > costs[b];
+	});
+	return order;
+}
+
+bool physics::Sweep::run(std::function<void(int)> start, std::function<void(int, const Measurement&)> report, std::function<void(int)> finish) noexcept {
+	using std::chrono::duration;
+	using std::chrono::steady_clock;
+
+	const auto count = static_cast<int>(jobs.size());
+	const auto order = schedule();
+	concurrency::ThreadPool pool { std::min(threads, count) };
+	std::mutex mutex { };
+	auto finished = 0;
+
+	pool.run(count, [this, count, &order, &start, &report, &finish, &mutex, &finished](int index) {
+		const auto job = order[index];
+		const auto begin = steady_clock::now();
+		auto quiet = log.limit(diagnostics::Level::warning);
+		statistics::StreamingAutoCorrelation xsquares { window };
+		Harmonic sim { jobs[job], quiet };
+
+		start(job);
+
+		const auto completed = sim.run([job, &report, &xsquares](const Measurement& measurement) {
+			report(job, measurement);
+			xsquares.add(measurement.x_square);
+		});
+
+		finish(job);
+
+		job_results[job] = completed ? ChainResult {
+			sim.compute_acceptance(),
+			sim.compute_x(),
+			sim.compute_x_square(),
+			xsquares.compute(),
+			sim.steps(),
+			false
+		} : Ensemble::failure(sim.steps());
+		job_durations[job] = duration<double>(steady_clock::now() - begin).count();
+
+		std::lock_guard<std::mutex> lock { mutex };
+
+		if (completed)
+			log.info("Finished job ", job, " (", ++finished, " of ", count, ") in ", job_durations[job], " s.");
+		else
+			log.error("Failed job ", job, " (", ++finished, " of ", count, ") in the thermalization.");
+	});
+
+	return std::none_of(job_results.begin(), job_results.end(), [](const ChainResult& r) {
+		return r.failed;
+	});
+}
+
+const std::vector<physics::Configuration>& physics::Sweep::configurations() const noexcept {
+	return jobs;
+}
+
+const std::vector<physics::ChainResult>& physics::Sweep::results() const noexcept {
+	return job_results;
+}
+
+const std::vector<double>& physics::Sweep::durations() const noexcept {
+	return job_durations;
+}
+
+bool physics::Sweep::expand(const std::string& grid, const physics::Configuration& base, std::vector<physics::Configuration>& configurations) noexcept {
+	std::vector<Configuration> product { base };
+
+	for (const auto& assignment : split(grid, " \t;")) {
+		const auto equals = assignment.find('=');
+
+		if (equals == std::string::npos)
+			return false;
+
+		const auto name = assignment.substr(0, equals);
+		const auto parameter = std::find_if(parameters().begin(), parameters().end(), [&name](const Parameter& p) {
+			return name == p.name || name == p.alternative;
+		});
+		std::vector<double> values { };
+
+		if (parameter == parameters().end() || !parse_values(assignment.substr(equals + 1), values))
+			return false;
+
+		std::vector<Configuration> next { };
+
+		for (const auto& cfg : product) {
+			for (const auto value : values) {
+				auto job = cfg;
+				parameter->assign(job, value);
+				next.push_back(job);
+			}
+		}
+
+		product.swap(next);
+	}
+
+	configurations.insert(configurations.end(), product.begin(), product.end());
+	return true;
+}
@@ -0,0 +1,146 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "team.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+* The number of polls of a barrier before the waiting thread yields its core.
+*/
+const int barrier_spins = 4096;
+
+concurrency::Team::Team(int size, bool pinned) noexcept :
+	members(),
+	task(),
+	generation(0),
+	finished(0),
+	stopping(false),
+	arrived(0),
+	phase(0) {
+	for (int rank = 1; rank < size; ++rank) {
+		members.emplace_back(&Team::work, this, rank);
+
+		if (pinned)
+			pin(members.back(), rank);
+	}
+}
+
+concurrency::Team::~Team() noexcept {
+	{
+		std::lock_guard<std::mutex> lock { mutex };
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (auto& member : members)
+		member.join();
+}
+
+int concurrency::Team::size() const noexcept {
+	return static_cast<int>(members.size()) + 1;
+}
+
+void concurrency::Team::run(std::function<void(int)> task) noexcept {
+	if (members.empty()) {
+		task(0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock { mutex };
+		this->task = task;
+		finished = 0;
+		++generation;
+	}
+
+	wake.notify_all();
+	task(0);
+
+	std::unique_lock<std::mutex> lock { mutex };
+	done.wait(lock, [this] { return finished == static_cast<int>(members.size()); });
+	this->task = nullptr;
+}
+
+void concurrency::Team::barrier() noexcept {
+	if (members.empty())
+		return;
+
+	// The last member to arrive opens the next phase, which the others poll for.
+	const auto current = phase.load(std::memory_order_acquire);
+
+	if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == size()) {
+		arrived.store(0, std::memory_order_relaxed);
+		phase.store(current + 1, std::memory_order_release);
+		return;
+	}
+
+	for (int spins = 0; phase.load(std::memory_order_acquire) == current; ++spins) {
+		if (spins >= barrier_spins)
+			std::this_thread::yield();
+	}
+}
+
+void concurrency::Team::work(int rank) noexcept {
+	std::uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock { mutex };
+
+	for (;;) {
+		wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+
+		if (stopping)
+			return;
+
+		seen = generation;
+		lock.unlock();
+		task(rank);
+		lock.lock();
+
+		if (++finished == static_cast<int>(members.size()))
+			done.notify_all();
+	}
+}
+
+void concurrency::Team::pin(std::thread& member, int rank) noexcept {
+#ifdef __linux__
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) <= rank)
+		return;
+
+	cpu_set_t core;
+	CPU_ZERO(&core);
+
+	for (int cpu = 0, index = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (CPU_ISSET(cpu, &allowed) && index++ == rank) {
+			CPU_SET(cpu, &core);
+			break;
+		}
+	}
+
+	pthread_setaffinity_np(member.native_handle(), sizeof(core), &core);
+#else
+	(void)member;
+	(void)rank;
+#endif
+}
@@ -0,0 +1,217 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "tempering.h"
+#include "profiling.h"
+#include <cmath>
+#include <algorithm>
+
+physics::Tempering::Tempering(const std::vector<physics::Configuration>& configurations, int interval, int threads, diagnostics::Logger& log) noexcept :
+	ntherm(configurations.front().ntherm),
+	nmeas(configurations.front().nmeas),
+	interval(interval > 0 ? interval : 1),
+	rounds(0),
+	target(configurations.front().target),
+	log(log),
+	rngs(),
+	dists(configurations.size(), std::uniform_real_distribution<double>(0.0, 1.0)),
+	lattices(),
+	adaptations(),
+	deltas(configurations.size(), 0.0),
+	rng(),
+	dist(0.0, 1.0),
+	pool(std::min(threads > 0 ? threads : concurrency::ThreadPool::hardware_threads(), static_cast<int>(configurations.size()))),
+	xsm(configurations.size(), 0.0),
+	xsqm(configurations.size(), 0.0),
+	acr(configurations.size(), 0.0),
+	attempts(configurations.size(), 0.0),
+	swaps(configurations.size(), 0.0) {
+	std::vector<int> seeds { };
+
+	for (const auto& cfg : configurations)
+		seeds.push_back(cfg.seed);
+
+	// The engines are referenced by the lattices, hence they must not be moved afterwards.
+	rngs = std::vector<std::mt19937>(seeds.begin(), seeds.end());
+
+	for (std::size_t r = 0; r < configurations.size(); ++r) {
+		const auto& cfg = configurations[r];
+		const Integrator integrator { cfg.integrator, cfg.nstep, cfg.tau, cfg.omelyan, cfg.substeps };
+		lattices.emplace_back(new Lattice(rngs[r], cfg.nt, integrator, cfg.omega_square, cfg.lambda, cfg.fourier, cfg.dimensions));
+		adaptations.emplace_back(target, integrator.step_size());
+	}
+
+	std::seed_seq sequence(seeds.begin(), seeds.end());
+	rng.seed(sequence);
+}
+
+int physics::Tempering::replicas() const noexcept {
+	return static_cast<int>(lattices.size());
+}
+
+bool physics::Tempering::run(std::function<void(int, const physics::Measurement&)> report) noexcept {
+	init();
+
+	if (!thermalize())
+		return false;
+
+	measure(report);
+	return true;
+}
+
+void physics::Tempering::init() noexcept {
+	// The initial trajectories are not checked, hence they could diverge for a step size that still needs to be adapted.
+	if (target > 0.0)
+		return;
+
+	pool.run(replicas(), [this](int r) {
+		for (int n = 0; n < 10; ++n) {
+			lattices[r]->randomize();
+			lattices[r]->integrate();
+		}
+	});
+}
+
+bool physics::Tempering::thermalize() noexcept {
+	const auto k = replicas();
+	const auto adapting = target > 0.0;
+	std::vector<double> arate(k, 0.0);
+	auto sufficient = true;
+	log.info("Running thermalization of ", k, " replicas ...");
+
+	for (int n = 0; n < ntherm; n += interval) {
+		const auto count = std::min(interval, ntherm - n);
+
+		pool.run(k, [this, count, adapting, &arate](int r) {
+			for (int i = 0; i < count; ++i) {
+				arate[r] += step(r);
+
+				if (adapting) {
+					const auto delta = deltas[r];
+					const auto probability = delta > 0.0 ? exp(-delta) : (delta <= 0.0 ? 1.0 : 0.0);
+					lattices[r]->step_size(adaptations[r].update(probability));
+				}
+			}
+		});
+
+		exchange(false);
+	}
+
+	log.info("Thermalization finished!");
+
+	for (int r = 0; r < k; ++r) {
+		if (adapting) {
+			lattices[r]->step_size(adaptations[r].average());
+			log.info("Adapted the step size of replica ", r, " to ε = ", lattices[r]->step_size(), " with ", lattices[r]->steps(), " steps.");
+
+			if (4.0 * arate[r] < ntherm)
+				log.warning("Low acceptance rate during the adaptation of the step size of replica ", r, "!");
+		} else if (4.0 * arate[r] < ntherm) {
+			log.error("Bad acceptance rate in thermalisation of replica ", r, "!");
+			sufficient = false;
+		}
+	}
+
+	return sufficient;
+}
+
+void physics::Tempering::measure(std::function<void(int, const physics::Measurement&)> report) noexcept {
+	const auto k = replicas();
+	log.info("Starting measurements of ", k, " replicas ...");
+
+	for (int n = 0; n < nmeas; n += interval) {
+		const auto count = std::min(interval, nmeas - n);
+
+		pool.run(k, [this, n, count, &report](int r) {
+			const auto& lattice = *lattices[r];
+
+			for (int i = 0; i < count; ++i) {
+				const auto accepted = step(r);
+				const auto xs = PROFILE_CALL(observables, lattice.x_average());
+				const auto xsq = PROFILE_CALL(observables, lattice.x_square_average());
+				const auto act = PROFILE_CALL(observables, lattice.action_average());
+				PROFILE_CALL(report, report(r, physics::Measurement { n + i, xs, xsq, act, accepted }));
+				acr[r] += accepted;
+				xsm[r] += xs;
+				xsqm[r] += xsq;
+			}
+		});
+
+		exchange(true);
+	}
+
+	log.info("Measurements finished!");
+}
+
+void physics::Tempering::exchange(bool counting) noexcept {
+	const auto k = replicas();
+
+	for (int r = rounds++ % 2; r + 1 < k; r += 2) {
+		auto& lower = *lattices[r];
+		auto& upper = *lattices[r + 1];
+		const auto delta = lower.action(upper) + upper.action(lower) - lower.action(lower) - upper.action(upper);
+		const auto accept = delta <= 0.0 || dist(rng) <= exp(-delta);
+
+		if (accept)
+			lower.exchange(upper);
+
+		if (counting) {
+			attempts[r] += 1.0;
+			swaps[r] += accept;
+		}
+	}
+}
+
+bool physics::Tempering::step(int r) noexcept {
+	auto& lattice = *lattices[r];
+	PROFILE_CALL(randomize, lattice.randomize());
+	lattice.store();
+	const auto a = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_CALL(integrate, lattice.integrate());
+	const auto b = PROFILE_CALL(hamilton, lattice.hamilton());
+	PROFILE_SCOPE(metropolis);
+	const auto delta = b - a;
+	const auto accept = delta <= 0.0 || dists[r](rngs[r]) <= exp(-delta);
+	deltas[r] = delta;
+
+	if (!accept)
+		lattice.restore();
+
+	return accept;
+}
+
+double physics::Tempering::compute_acceptance(int r) const noexcept {
+	return acr[r] / static_cast<double>(nmeas);
+}
+
+double physics::Tempering::compute_x(int r) const noexcept {
+	return xsm[r] / static_cast<double>(nmeas);
+}
+
+double physics::Tempering::compute_x_square(int r) const noexcept {
+	return xsqm[r] / static_cast<double>(nmeas);
+}
+
+double physics::Tempering::compute_exchange(int r) const noexcept {
+	return attempts[r] > 0.0 ? swaps[r] / attempts[r] : 0.0;
+}
+
+int physics::Tempering::steps(int r) const noexcept {
+	return lattices[r]->steps();
+}
@@ -0,0 +1,87 @@
+/*
+  This file is part of the Harmonic Oscillator sample.
+  Copyright (C) 2014 Florian Rappl
+  
+  This program is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of
+  the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with this program. If not, see
+  http://www.gnu.org/licenses/.
+*/
+
+#include "threadpool.h"
+
+concurrency::ThreadPool::ThreadPool(int threads) noexcept :
+	workers(),
+	task(),
+	count(0),
+	next(0),
+	pending(0),
+	stopping(false) {
+	const auto n = threads > 0 ? threads : hardware_threads();
+
+	for (int i = 0; i < n; ++i)
+		workers.emplace_back(&ThreadPool::work, this);
+}
+
+concurrency::ThreadPool::~ThreadPool() noexcept {
+	{
+		std::lock_guard<std::mutex> lock { mutex };
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+int concurrency::ThreadPool::size() const noexcept {
+	return static_cast<int>(workers.size());
+}
+
+int concurrency::ThreadPool::hardware_threads() noexcept {
+	const auto n = static_cast<int>(std::thread::hardware_concurrency());
+	return n > 0 ? n : 1;
+}
+
+void concurrency::ThreadPool::run(int count, std::function<void(int)> task) noexcept {
+	if (count <= 0)
+		return;
+
+	std::unique_lock<std::mutex> lock { mutex };
+	this->task = task;
+	this->count = count;
+	next = 0;
+	pending = count;
+	wake.notify_all();
+	done.wait(lock, [this] { return pending == 0; });
+	this->task = nullptr;
+}
+
+void concurrency::ThreadPool::work() noexcept {
+	std::unique_lock<std::mutex> lock { mutex };
+
+	for (;;) {
+		wake.wait(lock, [this] { return stopping || next < count; });
+
+		if (stopping)
+			return;
+
+		const auto index = next++;
+		lock.unlock();
+		task(index);
+		lock.lock();
+
+		if (--pending == 0)
+			done.notify_all();
+	}
+}